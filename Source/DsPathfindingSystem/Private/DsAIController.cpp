@@ -10,6 +10,10 @@
 ADsAIController::ADsAIController(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer.SetDefaultSubobjectClass<UDsGrid_PathFollowingComponent>(TEXT("PathFollowingComponent")))
 	, bPauseMoveCalled(false)
+	, bWaitingForTime(false)
+	, bStartPending(false)
+	, WaitSegmentIndex(-1)
+	, PendingAcceptanceRadius(-1)
 {}
 
 EPathFollowingRequestResult::Type ADsAIController::GridBasedMoveToLocation(const TArray<FVector>& Dests, const TArray<int32>& Indexes, float AcceptanceRadius)
@@ -36,6 +40,9 @@ EPathFollowingRequestResult::Type ADsAIController::GridBasedMoveToLocation(const
 	MoveReq.SetCanStrafe(true);
 
 	bPauseMoveCalled = false;
+	bWaitingForTime = false;
+	bStartPending = false;
+	TileTimes.Empty();
 
 	{
 		TSharedPtr<FNavigationPath, ESPMode::ThreadSafe> MetaPathPtr(new FNavigationPath(Dests, GetOwner()));
@@ -57,9 +64,70 @@ EPathFollowingRequestResult::Type ADsAIController::GridBasedMoveToLocation(const
 	return ResultData;
 }
 
+EPathFollowingRequestResult::Type ADsAIController::GridBasedMoveToSearchResult(const FSearchResult& SearchResult, float AcceptanceRadius, const ADsGrid* Grid)
+{
+	if (SearchResult.ResultState == ESearchResult::AlreadyAtGoal)
+		return EPathFollowingRequestResult::AlreadyAtGoal;
+
+	if (SearchResult.ResultState != ESearchResult::SearchSuccess)
+		return EPathFollowingRequestResult::Failed;
+
+	const bool bTimed = Grid && SearchResult.PathTimes.Num() == SearchResult.PathIndexes.Num();
+	if (bTimed && SearchResult.PathIndexes.Num() > 0 && Grid->GetReservationTime() < SearchResult.PathTimes[0] - 1)
+	{
+		// The first step is a wait, the move starts from Tick once its time comes
+		if (GetPathFollowingComponent() && GetPathFollowingComponent()->GetStatus() != EPathFollowingStatus::Idle)
+			PauseMovement();
+
+		TileIndexes = SearchResult.PathIndexes;
+		TileTimes = SearchResult.PathTimes;
+		TimingGrid = Grid;
+		PendingResult = SearchResult;
+		PendingAcceptanceRadius = AcceptanceRadius;
+		bWaitingForTime = false;
+		bStartPending = true;
+		return EPathFollowingRequestResult::RequestSuccessful;
+	}
+
+	const EPathFollowingRequestResult::Type Result = GridBasedMoveToLocation(SearchResult.PathResults, SearchResult.PathIndexes, AcceptanceRadius);
+	if (bTimed && Result == EPathFollowingRequestResult::RequestSuccessful)
+	{
+		TileTimes = SearchResult.PathTimes;
+		TimingGrid = Grid;
+	}
+	return Result;
+}
+
+bool ADsAIController::CanEnterTile(int32 TileIndex) const
+{
+	// The step onto a tile takes the time step before the one it is entered at
+	const ADsGrid* Grid = TimingGrid.Get();
+	return !Grid || !TileTimes.IsValidIndex(TileIndex) || Grid->GetReservationTime() >= TileTimes[TileIndex] - 1;
+}
+
+void ADsAIController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (bStartPending && CanEnterTile(0))
+	{
+		const FSearchResult StartResult = MoveTemp(PendingResult);
+		PendingResult = FSearchResult();
+		GridBasedMoveToSearchResult(StartResult, PendingAcceptanceRadius, TimingGrid.Get());
+	}
+	else if (bWaitingForTime && CanEnterTile(WaitSegmentIndex + 1))
+	{
+		bWaitingForTime = false;
+		ResumeMovement();
+	}
+}
+
 void ADsAIController::AbortMovement()
 {
 	TileIndexes.Empty();
+	TileTimes.Empty();
+	bWaitingForTime = false;
+	bStartPending = false;
 	StopMovement();
 
 	/*if (GetPathFollowingComponent())
@@ -122,6 +190,8 @@ void ADsAIController::OnPathFinished(TEnumAsByte<EPathFollowingResult::Type> Fla
 {
 	OnPathCompleted.Broadcast(TileIndexes.Num() > 0 ? TileIndexes.Last() : -1, Flag);
 	TileIndexes.Empty();
+	TileTimes.Empty();
+	bWaitingForTime = false;
 	auto Temp = OnGridPathFinished;
 	OnGridPathFinished.Clear();
 	Temp.Broadcast(Cast<AActor>(GetPawn()));
@@ -130,5 +200,11 @@ void ADsAIController::OnPathFinished(TEnumAsByte<EPathFollowingResult::Type> Fla
 
 bool ADsAIController::IsPathNeedsToPause(int32 InSegmentIndex)
 {
-	return bPauseMoveCalled;
+	if (bPauseMoveCalled)
+		return true;
+
+	// A timed path stays on the tile it reached until its next step may start, Tick resumes it
+	bWaitingForTime = !CanEnterTile(InSegmentIndex + 1);
+	WaitSegmentIndex = InSegmentIndex;
+	return bWaitingForTime;
 }
@@ -6,8 +6,18 @@
 */
 
 #include "DsGrid.h"
+#include "DsGridSearch.h"
+#include "DsGridQueryService.h"
+#include "DsGridJumpPointSearch.h"
+#include "DsGridHierarchy.h"
+#include "DsGridLandmarks.h"
+#include "DsGridPathCache.h"
+#include "DsGridComponents.h"
+#include "DsGridReservationTable.h"
+#include "Async/ParallelFor.h"
 
 DECLARE_CYCLE_STAT(TEXT("Grid~ASTAR"), STAT_ASTARSEARCH, STATGROUP_GRID);
+DECLARE_CYCLE_STAT(TEXT("Grid~ASTARBatch"), STAT_ASTARSEARCHBATCH, STATGROUP_GRID);
 DECLARE_CYCLE_STAT(TEXT("Grid~PathSearchAtRange"), STAT_PathSearchAtRange, STATGROUP_GRID);
 DECLARE_CYCLE_STAT(TEXT("Grid~ReTracePath"), STAT_ReTracePath, STATGROUP_GRID);
 DECLARE_CYCLE_STAT(TEXT("Grid~neighbor"), STAT_GetNeighborIndexes, STATGROUP_GRID);
@@ -32,16 +42,35 @@ ADsGrid::ADsGrid()
 	, GridY(0)
 	, TileOffset(FVector2D(0.0, 0.0))
 	, TileScale(FVector2D(1.0, 1.0))
+	, HexStepInverse(FVector2D::ZeroVector)
+	, GridOrigin(FVector::ZeroVector)
 	, bSquareGridDiagonalAllowed(false)
+	, GridVersion(0)
+	, NumReadScopes(0)
+	, bJumpPointTablesEnabled(false)
+	, bHierarchyEnabled(false)
+	, HierarchyClusterSize(16)
+	, HierarchyHeuristicFunction(EGridHeuristicFunction::Octile)
+	, bHierarchyUpdateQueued(false)
+	, bLandmarksEnabled(false)
+	, LandmarkCount(8)
+	, LandmarkHeuristicFunction(EGridHeuristicFunction::Octile)
+	, FlowFieldCacheSize(8)
+	, FlowFieldUseCount(0)
 {
 	Scene = CreateDefaultSubobject<USceneComponent>(TEXT("USceneComponent"));
 	Scene->SetMobility(EComponentMobility::Static);
 	RootComponent = Scene;
+
+	PathCache = MakeShared<FGridPathCache>();
+	Reservations = MakeShared<FGridReservationTable>();
 }
 
 void ADsGrid::BeginPlay()
 {
 	Super::BeginPlay();
+
+	GetQueryService();
 }
 
 void ADsGrid::Tick(float DeltaTime)
@@ -49,6 +78,71 @@ void ADsGrid::Tick(float DeltaTime)
 	Super::Tick(DeltaTime);
 }
 
+void ADsGrid::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (QueryService.IsValid())
+		QueryService->Flush();
+	LandmarkRefresh.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ADsGrid::BeginDestroy()
+{
+	if (QueryService.IsValid())
+		QueryService->Flush();
+	LandmarkRefresh.Reset();
+
+	Super::BeginDestroy();
+}
+
+void ADsGrid::BeginLayoutChange()
+{
+	if (QueryService.IsValid())
+		QueryService->Flush();
+	GridVersion++;
+
+	if (JumpPointTable.IsValid())
+		JumpPointTable->Empty();
+	Hierarchy.Reset();
+	LandmarkRefresh.Reset();
+	Landmarks.Reset();
+	InvalidateFlowFields();
+	PathCache->Empty();
+	Components.Reset();
+	Reservations->Empty();
+
+	OnLayoutChanged.Broadcast();
+}
+
+void ADsGrid::NotifyTileChanged(int32 Index)
+{
+	Tiles.UpdateCostClass(Index);
+	GridVersion++;
+
+	if (JumpPointTable.IsValid())
+		JumpPointTable->UpdateTile(Tiles, Index);
+	if (Hierarchy.IsValid())
+	{
+		Hierarchy->MarkTileChanged(Index);
+		QueueHierarchyUpdate();
+	}
+	if (Landmarks.IsValid() && !Landmarks->IsLowerBound(Tiles, Index))
+	{
+		// A cheaper tile can break the bounds, search without them until the refresh arrives.
+		Landmarks.Reset();
+		RefreshLandmarks();
+	}
+	InvalidateFlowFieldsAt(Index);
+	PathCache->MarkTileChanged(Index, GridVersion);
+	if (QueryService.IsValid())
+		QueryService->MarkTileChanged(Index, GridVersion);
+	if (Components.IsValid())
+		Components->UpdateTile(*this, Index);
+
+	OnTileChanged.Broadcast(Index);
+}
+
 bool ADsGrid::GenerateGridEx(EGridType InGridType, int32 InGridX, int32 InGridY, bool bIsSquareGridDiagonalAllowed, bool bUseCustomTileBounds, FBox CustomTileBounds, EGridTileOrder InTileOrder, TMap<int32, FNodeAttribute> NodeProperties, FVector2D InTileScale, FVector2D InTileOffset, bool bUseCustomGridLocation, FVector CustomGridLocation)
 {
 	ClearInstances();
@@ -67,15 +161,25 @@ bool ADsGrid::GenerateGridEx(EGridType InGridType, int32 InGridX, int32 InGridY,
 
 	TileBound = bUseCustomTileBounds ? CustomTileBounds : GridType == EGridType::Square ? FBox(FVector(-100.00000000000000, -100.00000000000000, -200.00001525878906), FVector(100.00000000000000, 100.00003051757812, 0.0000000000000000)) : FBox(FVector(-86.602546691894531, -100.00000000000000, -46.808815002441406), FVector(86.602546691894531, 100.00000000000000, 1.5258789062500000e-05));
 
-	const float boundX = TileBound.Max.X - TileBound.Min.X + TileOffset.X;
-	const float boundY = TileBound.Max.Y - TileBound.Min.Y - TileOffset.Y;
+	GridOrigin = GridLoc;
 
-	FVector NodeLoc = FVector::ZeroVector;
+	const FVector2D Step = GetTileStep();
+	HexStepInverse.X = FMath::IsNearlyZero(Step.X * TileScale.X) ? 0.0 : 1.0 / (Step.X * TileScale.X);
+	HexStepInverse.Y = FMath::IsNearlyZero(Step.Y * TileScale.Y) ? 0.0 : 1.0 / (Step.Y * 0.75 * TileScale.Y);
 
-	for (int32 i = 0; i < (GridX * GridY); i++)
+	Tiles.Init(GridX * GridY, GridOrigin.Z);
+	for (const auto& Property : NodeProperties)
 	{
-		CreateNewInstance(i, NodeProperties.Contains(i) ? NodeProperties[i] : FNodeAttribute());
+		if (IsValidIndex(Property.Key))
+			Tiles.SetAttribute(Property.Key, Property.Value);
 	}
+	Tiles.RefreshMinCost();
+
+	BuildAdjacency();
+	BuildJumpPointTable();
+	BuildHierarchy();
+	BuildComponents();
+	BuildLandmarks();
 
 	OnGridGenerated();
 
@@ -87,255 +191,518 @@ bool ADsGrid::Resize(int32 NewSizeX, int32 NewSizeY)
 	if (NewSizeX <= 0 || NewSizeY <= 0)
 		return false;
 
+	BeginLayoutChange();
+
 	int32 Old_HorizontalSize = GridX;
 	int32 Old_VerticalSize = GridY;
 
 	GridX = NewSizeX;
 	GridY = NewSizeY;
 
-	//if (GridX < Old_HorizontalSize || GridY < Old_VerticalSize)
+	FGridTileData OldTiles = MoveTemp(Tiles);
+	Tiles.Init(GridX * GridY, GridOrigin.Z, FNodeAttribute(true, 1.0f, ETileType::Grass));
+
+	for (int32 OldIndex = 0; OldIndex < OldTiles.Num(); OldIndex++)
 	{
-		auto TempGridData = Instances;
-		Instances.Empty();
-		for (const auto& Elem : TempGridData)
+		const int32 x = TileOrder == EGridTileOrder::ColumnMajor ? OldIndex / Old_VerticalSize : OldIndex % Old_HorizontalSize;
+		const int32 y = TileOrder == EGridTileOrder::ColumnMajor ? OldIndex % Old_VerticalSize : OldIndex / Old_HorizontalSize;
+
+		const int32 NewIndex = GetTileIndexAt(x, y);
+		if (NewIndex != -1)
 		{
-			auto& Tile = Elem.Value;
+			Tiles.SetAttribute(NewIndex, OldTiles.GetAttribute(OldIndex));
+			Tiles.Z[NewIndex] = OldTiles.Z[OldIndex];
+		}
+	}
+	Tiles.RefreshMinCost();
 
-			const int32 x = TileOrder == EGridTileOrder::ColumnMajor ? Elem.Key / Old_VerticalSize : Elem.Key % Old_HorizontalSize;
-			const int32 y = TileOrder == EGridTileOrder::ColumnMajor ? Elem.Key % Old_VerticalSize : Elem.Key / Old_HorizontalSize;
+	BuildAdjacency();
+	BuildJumpPointTable();
+	BuildHierarchy();
+	BuildComponents();
+	BuildLandmarks();
 
-			if (x >= 0 && x < GridX && y >= 0 && y < GridY)
+	OnResize(NewSizeX, NewSizeY);
+
+	return true;
+}
+
+void ADsGrid::BuildAdjacency()
+{
+	const int32 NumTiles = Tiles.Num();
+
+	// A successor row only depends on which borders the tile touches and its row parity. A predecessor row depends on the
+	// rows of the tiles next to it, so the distance to each border is counted up to 2. At most 3^4 * 2 classes.
+	TArray<int32> Representatives;
+	uint8 ClassOfKey[162];
+	FMemory::Memset(ClassOfKey, 0xFF, sizeof(ClassOfKey));
+
+	TileClasses.SetNumUninitialized(NumTiles);
+	for (int32 Index = 0; Index < NumTiles; Index++)
+	{
+		const int32 Column = TileOrder == EGridTileOrder::RowMajor ? Index % GridX : Index / GridY;
+		const int32 Row = TileOrder == EGridTileOrder::RowMajor ? Index / GridX : Index % GridY;
+		const int32 Key = (((FMath::Min(Column, 2) * 3 + FMath::Min(GridX - 1 - Column, 2)) * 3 + FMath::Min(Row, 2)) * 3 + FMath::Min(GridY - 1 - Row, 2)) * 2 + (Row & 1);
+
+		if (ClassOfKey[Key] == 0xFF)
+		{
+			ClassOfKey[Key] = (uint8)Representatives.Num();
+			Representatives.Add(Index);
+		}
+		TileClasses[Index] = ClassOfKey[Key];
+	}
+
+	auto Finish = [&](FGridAdjacency& Adjacency)
+		{
+			Adjacency.ClassBegin.Add(Adjacency.Offsets.Num());
+			Adjacency.TileClasses = TileClasses.GetData();
+			Adjacency.NumTiles = NumTiles;
+		};
+
+	auto Build = [&](FGridAdjacency& Adjacency, bool bBlockBorder)
+		{
+			Adjacency.Empty();
+			Adjacency.ClassBegin.Reserve(Representatives.Num() + 1);
+
+			for (const int32 Index : Representatives)
 			{
-				const int32 newIndex = TileOrder == EGridTileOrder::ColumnMajor ? (x * GridY) + y : (y * GridX) + x;
+				const int32 RowStart = Adjacency.Offsets.Num();
+				Adjacency.ClassBegin.Add(RowStart);
 
-				if (newIndex >= 0 && newIndex < GridX * GridY)
-					Instances.FindOrAdd(newIndex) = Elem.Value;
+				const FNeighbors Neighbors = GetNeighborTiles(Index, bBlockBorder);
+				auto AddNeighbor = [&](int32 Neighbor, ENeighborDirection Direction)
+					{
+						if (Neighbor < 0)
+							return;
+						// Wrapping on tiny grids can produce the same tile twice
+						for (int32 Edge = RowStart; Edge < Adjacency.Offsets.Num(); Edge++)
+						{
+							if (Adjacency.Offsets[Edge] == Neighbor - Index)
+								return;
+						}
+						Adjacency.Offsets.Add(Neighbor - Index);
+						Adjacency.Directions.Add(Direction);
+					};
+
+				AddNeighbor(Neighbors.EAST, ENeighborDirection::EAST);
+				AddNeighbor(Neighbors.WEST, ENeighborDirection::WEST);
+				AddNeighbor(Neighbors.SOUTH, ENeighborDirection::SOUTH);
+				AddNeighbor(Neighbors.NORTH, ENeighborDirection::NORTH);
+				AddNeighbor(Neighbors.SOUTHEAST, ENeighborDirection::SOUTH_EAST);
+				AddNeighbor(Neighbors.SOUTHWEST, ENeighborDirection::SOUTH_WEST);
+				AddNeighbor(Neighbors.NORTHWEST, ENeighborDirection::NORTH_WEST);
+				AddNeighbor(Neighbors.NORTHEAST, ENeighborDirection::NORTH_EAST);
 			}
-			else
+			Finish(Adjacency);
+		};
+
+	// Every edge onto a tile is one of the class edges seen from the other end, the edge has to belong to the class of that tile
+	auto Transpose = [&](const FGridAdjacency& Adjacency, FGridAdjacency& Predecessors)
+		{
+			Predecessors.Empty();
+			Predecessors.ClassBegin.Reserve(Representatives.Num() + 1);
+
+			for (const int32 Index : Representatives)
 			{
-				//DestroyTile(Elem.Key);
+				Predecessors.ClassBegin.Add(Predecessors.Offsets.Num());
+				for (int32 Edge = 0; Edge < Adjacency.Offsets.Num(); Edge++)
+				{
+					const int32 Predecessor = Index - Adjacency.Offsets[Edge];
+					if (Predecessor < 0 || Predecessor >= NumTiles || Edge < Adjacency.Begin(Predecessor) || Edge >= Adjacency.End(Predecessor))
+						continue;
+
+					Predecessors.Offsets.Add(-Adjacency.Offsets[Edge]);
+					Predecessors.Directions.Add(Adjacency.Directions[Edge]);
+				}
 			}
-		}
+			Finish(Predecessors);
+		};
+
+	Build(BlockedAdjacency, true);
+	Build(WrappedAdjacency, false);
+	Transpose(BlockedAdjacency, BlockedPredecessors);
+	Transpose(WrappedAdjacency, WrappedPredecessors);
+}
+
+FGridQueryContext::FGridQueryContext(const FAStarPreferences& InPreferences, int32 NumTiles)
+	: Preferences(InPreferences)
+{
+	FMemory::Memzero(IgnoredTileTypes, sizeof(IgnoredTileTypes));
+	for (const ETileType TileType : Preferences.TileTypesToIgnore)
+	{
+		const uint8 Bit = (uint8)TileType;
+		IgnoredTileTypes[Bit >> 6] |= 1ull << (Bit & 63);
 	}
-	//else if (GridX > Old_HorizontalSize || GridY > Old_VerticalSize)
+
+	if (Preferences.TileIndexesToFilter.Num() > 0)
 	{
-		for (int32 ii = 0; ii < GridX * GridY; ii++)
+		FilteredTiles.Init(false, NumTiles);
+		for (const int32 Index : Preferences.TileIndexesToFilter)
 		{
-			if (Instances.Contains(ii))
-				continue;
-			CreateNewInstance(ii, FNodeAttribute(true, 1.0f, ETileType::Grass));
+			if (Index >= 0 && Index < NumTiles)
+				FilteredTiles[Index] = true;
 		}
 	}
 
-	OnResize(NewSizeX, NewSizeY);
+	IgnoredPlayerIDs.Append(Preferences.PlayerIDsToIgnore);
+}
 
-	return true;
+FGridQueryContext ADsGrid::MakeQueryContext(const FAStarPreferences& Preferences) const
+{
+	return FGridQueryContext(Preferences, Tiles.Num());
 }
 
 FSearchResult ADsGrid::AStarSearch(int32 StartIndex, int32 EndIndex, FAStarPreferences Preferences, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction) const
 {
-	SCOPE_CYCLE_COUNTER(STAT_ASTARSEARCH);
+	// Async queries read a snapshot and custom NodeBehavior costs can change without a tile edit
+	if (PathCache->IsEnabled() && IsInGameThread() && &GetTileData() == &Tiles && !HasCustomNodeBehavior())
+		return CachedAStarSearch(StartIndex, EndIndex, Preferences, bStopAtNeighborLocation, HeuristicFunction);
 
-	if (!IsValidIndex(StartIndex) || !IsValidIndex(EndIndex))
-		return FSearchResult();
+	return AStarSearchWithContext(StartIndex, EndIndex, MakeQueryContext(Preferences), bStopAtNeighborLocation, HeuristicFunction);
+}
+
+TArray<FSearchResult> ADsGrid::AStarSearchBatch(const TArray<FAStarSearchQuery>& Queries) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ASTARSEARCHBATCH);
 
+	TArray<FSearchResult> Results;
+	Results.SetNum(Queries.Num());
 
-	float NodeCostScale = 1.0f;
+	// Workers read the same tiles as the caller, including the snapshot when called from an async query.
+	const FGridTileData* ReadView = &GetTileData();
 
-	if ((GridX * GridY) == 0)
-		return FSearchResult();
+	// Custom NodeBehavior overrides are not called from several threads at once unless the grid opts out
+	EParallelForFlags Flags = EParallelForFlags::Unbalanced;
+	if (NodeBehaviorRequiresGameThread())
+		Flags = Flags | EParallelForFlags::ForceSingleThread;
 
-	if (StartIndex == EndIndex)
+	// Every worker thread runs its searches on its own pooled scratch (see FScopedGridSearchScratch).
+	ParallelFor(Queries.Num(), [&](int32 QueryIndex)
+		{
+			const FAStarSearchQuery& Query = Queries[QueryIndex];
+			FGridReadScope ReadScope(this, ReadView);
+			Results[QueryIndex] = AStarSearchWithContext(Query.StartIndex, Query.EndIndex, MakeQueryContext(Query.Preferences), Query.bStopAtNeighborLocation, Query.HeuristicFunction);
+		}, Flags);
+
+	return Results;
+}
+
+FSearchResult ADsGrid::AStarSearchWithContext(int32 StartIndex, int32 EndIndex, const FGridQueryContext& Context, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ASTARSEARCH);
+
+	if (IsGoalUnreachable(StartIndex, EndIndex, Context, bStopAtNeighborLocation))
 	{
 		FSearchResult Result;
 		Result.EndPoint = EndIndex;
 		Result.bStopAtNeighborLocation = bStopAtNeighborLocation;
-		Result.ResultState = ESearchResult::AlreadyAtGoal;
 		return Result;
 	}
-	else if (bStopAtNeighborLocation)
-	{
-		auto stopAtNeighbor = GetNeighborTilesAsArray(EndIndex, Preferences.bBlockBorder);
-		if (stopAtNeighbor.Contains(StartIndex))
-		{
-			FSearchResult Result;
-			Result.EndPoint = EndIndex;
-			Result.bStopAtNeighborLocation = bStopAtNeighborLocation;
-			Result.ResultState = ESearchResult::AlreadyAtGoal;
-			return Result;
-		}
-	}
 
-	// No need to create this outside of the function. No one should use this.
-	struct FANode
-	{
-	public:
-
-		uint32 Closed : 1;
-		int32 OpenSetIndex = -1;
-		int32 parent = -1;
-		int32 parentCount = 0;
-		float TotalCost = 0.0f;
-		float TraversalCost = 0.0f;
-		float HeuristicCost = 0.0f;
-		float NodeCostCount = 0.0f;
-		float NodeCost;
-
-		FANode()
-			: Closed(false)
-			, NodeCost(1.0f)
-		{}
-	};
+	const bool bBidirectional = Context.Preferences.bBidirectional && Context.Preferences.TotalNodeCostLimit < 0;
 
-	// Not to confuse with retracePath Function
-	auto Retrace = [&](const int32 start, const int32 end, const TMap<int32, FANode>& StructData) -> FSearchResult
+	return DispatchGridNeighborKernel(GridType, bSquareGridDiagonalAllowed, Context.Preferences.bBlockBorder, [&](auto Kernel)
 		{
-			int32 current = end;
-			FSearchResult Result;
+			return DispatchGridCostPolicy(*this, Context, [&](auto Policy)
+				{
+					if (bBidirectional)
+						return BidirectionalSearchImpl<decltype(Kernel), decltype(Policy)>(StartIndex, EndIndex, Context, bStopAtNeighborLocation, HeuristicFunction, Policy);
+					return AStarSearchImpl<decltype(Kernel), decltype(Policy)>(StartIndex, EndIndex, Context, bStopAtNeighborLocation, HeuristicFunction, Policy);
+				});
+		});
+}
 
-			Result.EndPoint = EndIndex;
-			Result.bStopAtNeighborLocation = bStopAtNeighborLocation;
+template<typename KernelType, typename PolicyType>
+FSearchResult ADsGrid::AStarSearchImpl(int32 StartIndex, int32 EndIndex, const FGridQueryContext& Context, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction, const PolicyType& Policy) const
+{
+	const FAStarPreferences& Preferences = Context.Preferences;
 
-			while (current != start)
-			{
-				if (current <= -1) {
-					Result.ResultState = ESearchResult::SearchFail;
-					return Result;
-				}
+	if (!IsValidIndex(StartIndex) || !IsValidIndex(EndIndex))
+		return FSearchResult();
 
-				FVector currentVector = Instances[current].Location;
-				Result.PathResults.Insert(currentVector, 0);
-				Result.PathIndexes.Insert(current, 0);
-				Result.PathLength = Result.PathLength + 1;
-				if (StructData.Find(current)) {
-					float currentCost = StructData[current].NodeCost;
-					Result.TotalNodeCost += currentCost;
-					Result.PathCosts.Add(current, currentCost);
-					Result.Parents.Add(current, StructData[current].parent);
-					current = StructData[current].parent;
-				}
-				else {
-					Result.ResultState = ESearchResult::SearchFail;
-					return Result;
-				}
-			}
-			Result.ResultState = ESearchResult::SearchSuccess;
+	FSearchResult AStarResult;
+	AStarResult.EndPoint = EndIndex;
+	AStarResult.bStopAtNeighborLocation = bStopAtNeighborLocation;
 
-			return Result;
-		};
+	TArray<int32> StopAtNeighbor;
+	if (bStopAtNeighborLocation)
+		StopAtNeighbor = GetNeighborTilesAsArray(EndIndex, Preferences.bBlockBorder);
+
+	if (StartIndex == EndIndex || StopAtNeighbor.Contains(StartIndex))
+	{
+		AStarResult.ResultState = ESearchResult::AlreadyAtGoal;
+		return AStarResult;
+	}
+
+	AStarResult.ResultState = ESearchResult::SearchFail;
+
+	if (!bStopAtNeighborLocation && !Policy.GetAccess(-1, EndIndex, EndIndex).bAccess)
+		return AStarResult;
+
+	// Reused between searches, indexed by tile index.
+	FScopedGridSearchScratch GridGraph(GridX * GridY);
+	GridGraph->Visit(StartIndex);
+	GridGraph->PushOpen(StartIndex);
 
-	FSearchResult			AStarResult;
-	TMap<int32, FANode>		GridGraph;
-	TArray<int32>			stopAtNeighbor;
+	const FGridEndGoal Goal(EndIndex, bStopAtNeighborLocation ? &StopAtNeighbor : nullptr);
+	const FGridEndHeuristic Heuristic(*this, HeuristicFunction, GetHeuristicScale(HeuristicFunction, Preferences), EndIndex, bStopAtNeighborLocation ? nullptr : FindLandmarks(Context, HeuristicFunction));
 
 	TArray<int32> ObstacleIndexes;
+	FGridAStarRun Run;
+	if (Preferences.bRecordObstacleIndexes)
+		Run.ObstacleIndexes = &ObstacleIndexes;
 
-	AStarResult.EndPoint = EndIndex;
-	AStarResult.bStopAtNeighborLocation = bStopAtNeighborLocation;
+	RunAStar<KernelType>(*GridGraph, Run, Context, HeuristicFunction, Policy, Goal, Heuristic);
 
-	if (NodeCostScale < 1.0f)
-		NodeCostScale = 1.0f;
+	if (Run.Status == FGridAStarRun::EStatus::Found || Run.Status == FGridAStarRun::EStatus::LimitExceeded)
+	{
+		// Over the cost limit the path leads to the tile whose expansion went past it
+		AStarResult = RetraceSearch(*GridGraph, StartIndex, Run.LastIndex, EndIndex, bStopAtNeighborLocation);
+		if (Run.Status == FGridAStarRun::EStatus::LimitExceeded && Preferences.bFailIfTotalNodeCostExceeded)
+			AStarResult.ResultState = ESearchResult::SearchFail;
+	}
+	else
+	{
+		for (const int32 ObstacleIndex : ObstacleIndexes)
+			AStarResult.ObstacleIndexes.AddUnique(ObstacleIndex);
+	}
 
-	AStarResult.ResultState = ESearchResult::SearchFail;
+	AStarResult.NumForwardExpansions = Run.NumExpansions;
+	return AStarResult;
+}
+
+FSearchResult ADsGrid::RetraceSearch(const FGridSearchScratch& Scratch, int32 StartIndex, int32 LastIndex, int32 EndPoint, bool bStopAtNeighborLocation) const
+{
+	FSearchResult Result;
+	Result.EndPoint = EndPoint;
+	Result.bStopAtNeighborLocation = bStopAtNeighborLocation;
 
-	TArray<FANode> fCostHeap;
-	fCostHeap.AddDefaulted(1);
-	fCostHeap[0].OpenSetIndex = StartIndex;
-	fCostHeap[0].parent = StartIndex;
+	for (int32 Current = LastIndex; Current != StartIndex;)
+	{
+		const FGridSearchNode* Node = Scratch.Find(Current);
+		if (!Node || Node->Parent <= -1)
+		{
+			Result.ResultState = ESearchResult::SearchFail;
+			return Result;
+		}
 
-	auto Predicate = [&](const FANode& hIndex_A, const FANode& hIndex2_B) {return hIndex_A.TotalCost < hIndex2_B.TotalCost; };
+		Result.PathResults.Insert(GetTileLocation(Current), 0);
+		Result.PathIndexes.Insert(Current, 0);
+		Result.PathLength = Result.PathLength + 1;
+		Result.TotalNodeCost += Node->NodeCost;
+		Result.PathCosts.Add(Current, Node->NodeCost);
+		Result.Parents.Add(Current, Node->Parent);
+		Current = Node->Parent;
+	}
+	Result.ResultState = ESearchResult::SearchSuccess;
 
-	fCostHeap.Heapify(Predicate);
+	return Result;
+}
 
-	if (StartIndex < 0 || EndIndex < 0 || StartIndex >= (GridX * GridY) || EndIndex >= (GridX * GridY) || (!bStopAtNeighborLocation && !NodeBehavior(-1, EndIndex, EndIndex, Preferences).bAccess))
-		return AStarResult;
+template<typename KernelType, typename PolicyType>
+FSearchResult ADsGrid::BidirectionalSearchImpl(int32 StartIndex, int32 EndIndex, const FGridQueryContext& Context, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction, const PolicyType& Policy) const
+{
+	const FAStarPreferences& Preferences = Context.Preferences;
 
+	if (!IsValidIndex(StartIndex) || !IsValidIndex(EndIndex))
+		return FSearchResult();
+
+	FSearchResult Result;
+	Result.EndPoint = EndIndex;
+	Result.bStopAtNeighborLocation = bStopAtNeighborLocation;
+
+	// The goal side starts from every tile the search may stop on
+	TArray<int32> GoalIndexes;
 	if (bStopAtNeighborLocation)
-		stopAtNeighbor = GetNeighborTilesAsArray(EndIndex, Preferences.bBlockBorder);
+		GoalIndexes = GetNeighborTilesAsArray(EndIndex, Preferences.bBlockBorder);
+	else
+		GoalIndexes.Add(EndIndex);
 
-	while (fCostHeap.Num() != 0)
+	if (StartIndex == EndIndex || GoalIndexes.Contains(StartIndex))
 	{
-		int32 CurrentIndex = fCostHeap[0].OpenSetIndex;
+		Result.ResultState = ESearchResult::AlreadyAtGoal;
+		return Result;
+	}
+
+	if (!bStopAtNeighborLocation && !Policy.GetAccess(-1, EndIndex, EndIndex).bAccess)
+		return Result;
+
+	FScopedGridSearchScratch Forward(GridX * GridY);
+	FScopedGridSearchScratch Backward(GridX * GridY);
+
+	const FGridAdjacency& Successors = KernelType::GetAdjacency(*this);
+	const FGridAdjacency& Predecessors = KernelType::GetPredecessors(*this);
+	const FVector StartLocation = GetTileLocation(StartIndex);
 
-		if (bStopAtNeighborLocation ? stopAtNeighbor.Contains(CurrentIndex) : CurrentIndex == EndIndex)
+	TArray<FVector> GoalLocations;
+	GoalLocations.Reserve(GoalIndexes.Num());
+	for (const int32 GoalIndex : GoalIndexes)
+		GoalLocations.Add(GetTileLocation(GoalIndex));
+
+	const FGridLandmarks* LandmarkBounds = bStopAtNeighborLocation ? nullptr : FindLandmarks(Context, HeuristicFunction);
+	const float HeuristicScale = GetHeuristicScale(HeuristicFunction, Preferences);
+
+	// The closest goal keeps the forward estimate a lower bound when there are several
+	auto ForwardHeuristic = [&](int32 Index, const FVector& Location)
 		{
-			if (bStopAtNeighborLocation) {
-				AStarResult = Retrace(StartIndex, CurrentIndex, GridGraph);
-			}
-			else {
-				AStarResult = Retrace(StartIndex, CurrentIndex, GridGraph);
-			}
-			return AStarResult;
-		}
+			float Heuristic = MAX_flt;
+			for (const FVector& GoalLocation : GoalLocations)
+				Heuristic = FMath::Min(Heuristic, GetHeuristic(HeuristicFunction, Location, GoalLocation, HeuristicScale));
+			return LandmarkBounds ? FMath::Max(Heuristic, LandmarkBounds->GetLowerBound(Index, EndIndex)) : Heuristic;
+		};
+	auto BackwardHeuristic = [&](int32 Index, const FVector& Location)
+		{
+			const float Heuristic = GetHeuristic(HeuristicFunction, Location, StartLocation, HeuristicScale);
+			return LandmarkBounds ? FMath::Max(Heuristic, LandmarkBounds->GetLowerBound(StartIndex, Index)) : Heuristic;
+		};
 
-		fCostHeap.HeapPopDiscard(Predicate);
-		auto& CurrentNode = GridGraph.FindOrAdd(CurrentIndex);
-		CurrentNode.Closed = true;
+	Forward->Visit(StartIndex).TotalCost = ForwardHeuristic(StartIndex, StartLocation);
+	Forward->PushOpen(StartIndex);
 
-		FTileNeighborResult NeighborIndexes = GetNeighborIndexes(CurrentIndex, EndIndex, Preferences);
+	for (const int32 GoalIndex : GoalIndexes)
+	{
+		auto& GoalNode = Backward->Visit(GoalIndex);
+		GoalNode.HeuristicCost = BackwardHeuristic(GoalIndex, GetTileLocation(GoalIndex));
+		GoalNode.TotalCost = GoalNode.HeuristicCost;
+		Backward->PushOpen(GoalIndex);
+	}
 
-		if (Preferences.bRecordObstacleIndexes)
-			ObstacleIndexes.Append(NeighborIndexes.ObstacleIndexes);
+	TArray<int32> ObstacleIndexes;
+	float BestCost = MAX_flt;
+	int32 MeetingIndex = INDEX_NONE;
 
-		for (const auto& Tile : NeighborIndexes.Neighbors)
+	auto StepCost = [&](const FVector& FromLocation, const FVector& ToLocation, const FGridStepAccess& Access)
 		{
-			auto& NextNode = GridGraph.FindOrAdd(Tile.Key);
+			return GetStepDistance(HeuristicFunction, FromLocation, ToLocation) + (Preferences.bOverrideNodeCostToOne ? 1.0f : (Access.NodeCost * Access.NodeCostScale));
+		};
 
-			if (!NextNode.Closed)
-			{
-				float TraversalCost = (CurrentNode.TraversalCost + GetHeuristic(HeuristicFunction, Instances[CurrentIndex].Location, Instances[Tile.Key].Location)) + (Preferences.bOverrideNodeCostToOne ? 1.0f : ((Tile.Value.NodeCost * Tile.Value.NodeCostScale) * NodeCostScale));
+	/*
+	* Relaxes Next through Current on one side. Nodes of the goal side store the next tile towards the goal as Parent
+	* and the cost of entering it as NodeCost, so both sides hold the same per tile data the path needs.
+	*/
+	auto Relax = [&](FGridSearchScratch& Side, const FGridSearchScratch& OtherSide, const FGridSearchNode& CurrentNode, int32 CurrentIndex, int32 NextIndex,
+		float TraversalCost, const FGridStepAccess& Access, float HeuristicCost)
+		{
+			auto& NextNode = Side.Visit(NextIndex);
+			if (NextNode.bClosed)
+				return;
 
-				auto PredicateIndex = [&](const FANode fCostH) {return fCostH.OpenSetIndex == Tile.Key; };
+			const bool bIsOpen = Side.IsOpen(NextIndex);
+			if (TraversalCost < NextNode.TraversalCost || !bIsOpen)
+			{
+				NextNode.NodeCost = Preferences.bOverrideNodeCostToOne ? 1.0f : Access.NodeCost;
+				NextNode.TraversalCost = TraversalCost;
+				NextNode.Parent = CurrentIndex;
+				NextNode.ParentCount = CurrentNode.ParentCount + 1;
+				NextNode.HeuristicCost = HeuristicCost;
+				NextNode.TotalCost = TraversalCost + HeuristicCost;
+
+				if (bIsOpen)
+					Side.DecreaseKey(NextIndex);
+				else
+					Side.PushOpen(NextIndex);
+			}
 
-				if (TraversalCost < NextNode.TraversalCost || !fCostHeap.ContainsByPredicate(PredicateIndex))
+			if (const FGridSearchNode* OtherNode = OtherSide.Find(NextIndex))
+			{
+				const float MeetingCost = NextNode.TraversalCost + OtherNode->TraversalCost;
+				if (MeetingCost < BestCost)
 				{
-					NextNode.NodeCost = Preferences.bOverrideNodeCostToOne ? 1.0f : Tile.Value.NodeCost;
-					NextNode.TraversalCost = TraversalCost;
-					NextNode.parent = CurrentIndex;
-					NextNode.NodeCostCount = CurrentNode.NodeCostCount + (Preferences.bOverrideNodeCostToOne ? 1.0f : Tile.Value.NodeCost);
-					NextNode.parentCount = CurrentNode.parentCount + 1;
-					NextNode.OpenSetIndex = Tile.Key;
-					NextNode.HeuristicCost = GetHeuristic(HeuristicFunction, Instances[Tile.Key].Location, Instances[EndIndex].Location);	// NodePredicate
-					NextNode.TotalCost = NextNode.TraversalCost + NextNode.HeuristicCost;	// NodePredicate
-
-					if (Preferences.TotalNodeCostLimit >= 0 && NextNode.TotalCost > Preferences.TotalNodeCostLimit)
-					{
-						if (Preferences.bRecordObstacleIndexes)
-						{
-							for (const auto& idx : ObstacleIndexes)
-							{
-								AStarResult.ObstacleIndexes.AddUnique(idx);
-							}
-						}
-
-						AStarResult = Retrace(StartIndex, CurrentIndex, GridGraph);
+					BestCost = MeetingCost;
+					MeetingIndex = NextIndex;
+				}
+			}
+		};
 
-						if (Preferences.bFailIfTotalNodeCostExceeded)
-						{
-							AStarResult.ResultState = ESearchResult::SearchFail;
-						}
+	while (Forward->HasOpen() && Backward->HasOpen())
+	{
+		// With consistent heuristics no path through the open sets can beat BestCost once either frontier passes it
+		const float ForwardBound = Forward->Find(Forward->PeekOpen())->TotalCost;
+		const float BackwardBound = Backward->Find(Backward->PeekOpen())->TotalCost;
+		if (BestCost <= FMath::Max(ForwardBound, BackwardBound))
+			break;
 
-						return AStarResult;
-					}
+		// Grow the smaller frontier
+		if (Forward->OpenNum() <= Backward->OpenNum())
+		{
+			const int32 CurrentIndex = Forward->PopOpen();
+			auto& CurrentNode = Forward->Visit(CurrentIndex);
+			CurrentNode.bClosed = true;
+			Result.NumForwardExpansions++;
 
-					if (!fCostHeap.ContainsByPredicate(PredicateIndex))
+			const FVector CurrentLocation = GetTileLocation(CurrentIndex);
+			KernelType::ForEach(Successors, CurrentIndex, [&](int32 NeighborIndex, ENeighborDirection Direction) -> bool
+				{
+					const FGridStepAccess Access = Policy.GetAccess(CurrentIndex, NeighborIndex, EndIndex, Direction);
+					if (!Access.bAccess)
 					{
-						fCostHeap.HeapPush(NextNode, Predicate);
+						if (Preferences.bRecordObstacleIndexes)
+							ObstacleIndexes.Add(NeighborIndex);
+						return true;
 					}
-				}
-			}
+
+					const FVector NextLocation = GetTileLocation(NeighborIndex);
+					Relax(*Forward, *Backward, CurrentNode, CurrentIndex, NeighborIndex, CurrentNode.TraversalCost + StepCost(CurrentLocation, NextLocation, Access), Access, ForwardHeuristic(NeighborIndex, NextLocation));
+					return true;
+				});
+		}
+		else
+		{
+			const int32 CurrentIndex = Backward->PopOpen();
+			auto& CurrentNode = Backward->Visit(CurrentIndex);
+			CurrentNode.bClosed = true;
+			Result.NumBackwardExpansions++;
+
+			// The edge runs from the predecessor into CurrentIndex, so it is costed exactly like the forward step
+			const FVector CurrentLocation = GetTileLocation(CurrentIndex);
+			KernelType::ForEach(Predecessors, CurrentIndex, [&](int32 PredecessorIndex, ENeighborDirection Direction) -> bool
+				{
+					const FGridStepAccess Access = Policy.GetAccess(PredecessorIndex, CurrentIndex, EndIndex, Direction);
+					if (!Access.bAccess)
+						return true;
+
+					const FVector PreviousLocation = GetTileLocation(PredecessorIndex);
+					Relax(*Backward, *Forward, CurrentNode, CurrentIndex, PredecessorIndex, CurrentNode.TraversalCost + StepCost(PreviousLocation, CurrentLocation, Access), Access, BackwardHeuristic(PredecessorIndex, PreviousLocation));
+					return true;
+				});
 		}
 	}
 
 	if (Preferences.bRecordObstacleIndexes)
 	{
 		for (const auto& idx : ObstacleIndexes)
-		{
-			AStarResult.ObstacleIndexes.AddUnique(idx);
-		}
+			Result.ObstacleIndexes.AddUnique(idx);
 	}
 
-	return AStarResult;
+	if (MeetingIndex == INDEX_NONE)
+		return Result;
+
+	int32 Previous = StartIndex;
+	auto AddPathTile = [&](int32 Index, float NodeCost)
+		{
+			Result.PathResults.Add(GetTileLocation(Index));
+			Result.PathIndexes.Add(Index);
+			Result.PathLength = Result.PathLength + 1;
+			Result.TotalNodeCost += NodeCost;
+			Result.PathCosts.Add(Index, NodeCost);
+			Result.Parents.Add(Index, Previous);
+			Previous = Index;
+		};
+
+	// Start side, collected from the meeting tile back to the start
+	TArray<int32> StartSide;
+	for (int32 Current = MeetingIndex; Current != StartIndex; Current = Forward->Find(Current)->Parent)
+		StartSide.Add(Current);
+	for (int32 PathIndex = StartSide.Num() - 1; PathIndex >= 0; PathIndex--)
+		AddPathTile(StartSide[PathIndex], Forward->Find(StartSide[PathIndex])->NodeCost);
+
+	// Goal side, every node points at the next tile and holds the cost of entering it
+	for (const FGridSearchNode* Node = Backward->Find(MeetingIndex); Node->Parent != -1; Node = Backward->Find(Node->Parent))
+		AddPathTile(Node->Parent, Node->NodeCost);
+
+	Result.ResultState = ESearchResult::SearchSuccess;
+
+	return Result;
 }
 
 #if 0
@@ -495,10 +862,10 @@ FSearchResult ADsGrid::PathSearchAtRange(int32 StartIndex, int32 AtRange, FAStar
 			Result.PathIndexes.Add(Index);
 			Result.PathCosts.Add(Index, Cost);
 
-			// Reconstruct location (Assuming you have an Instances array)
-			if (Instances.Contains(Index))
+			// Reconstruct location (tile storage is dense, every valid index has a location)
+			if (IsValidIndex(Index))
 			{
-				Result.PathResults.Add(Instances[Index].Location);
+				Result.PathResults.Add(GetTileLocation(Index));
 			}
 
 			// Add Parent
@@ -570,14 +937,14 @@ FSearchResult ADsGrid::RetracePath(int32 StartIndex, int32 EndIndex, FSearchResu
 				}
 
 				// Validation check
-				if (CurrentIndex < 0 || !Instances.Contains(CurrentIndex))
+				if (CurrentIndex < 0 || !IsValidIndex(CurrentIndex))
 				{
 					LocalResult.ResultState = ESearchResult::SearchFail;
 					return LocalResult;
 				}
 
 				// 1. Add Data (Reverse order initially)
-				LocalResult.PathResults.Add(Instances[CurrentIndex].Location);
+				LocalResult.PathResults.Add(GetTileLocation(CurrentIndex));
 				LocalResult.PathIndexes.Add(CurrentIndex);
 
 				// 2. Accumulate Cost
@@ -602,9 +969,9 @@ FSearchResult ADsGrid::RetracePath(int32 StartIndex, int32 EndIndex, FSearchResu
 			}
 
 			// Add the start node logic (usually start node has 0 cost, but needs to be in the path array)
-			/*if (Instances.Contains(startIndex))
+			/*if (IsValidIndex(startIndex))
 			{
-				LocalResult.PathResults.Add(Instances[startIndex].Location);
+				LocalResult.PathResults.Add(GetTileLocation(startIndex));
 				LocalResult.PathIndexes.Add(startIndex);
 			}*/
 
@@ -697,159 +1064,114 @@ FSearchResult ADsGrid::RetracePath(int32 StartIndex, int32 EndIndex, FSearchResu
 #else
 
 FSearchResult ADsGrid::PathSearchAtRange(int32 StartIndex, int32 AtRange, FAStarPreferences Preferences) const
+{
+	return PathSearchAtRangeWithContext(StartIndex, AtRange, MakeQueryContext(Preferences));
+}
+
+FSearchResult ADsGrid::PathSearchAtRangeWithContext(int32 StartIndex, int32 AtRange, const FGridQueryContext& Context) const
 {
 	SCOPE_CYCLE_COUNTER(STAT_PathSearchAtRange);
 
+	return DispatchGridNeighborKernel(GridType, bSquareGridDiagonalAllowed, Context.Preferences.bBlockBorder, [&](auto Kernel)
+		{
+			return DispatchGridCostPolicy(*this, Context, [&](auto Policy)
+				{
+					return PathSearchAtRangeImpl<decltype(Kernel), decltype(Policy)>(StartIndex, AtRange, Context, Policy);
+				});
+		});
+}
+
+template<typename KernelType, typename PolicyType>
+FSearchResult ADsGrid::PathSearchAtRangeImpl(int32 StartIndex, int32 AtRange, const FGridQueryContext& Context, const PolicyType& Policy) const
+{
+	const FAStarPreferences& Preferences = Context.Preferences;
+
 	if (!IsValidIndex(StartIndex))
 		return FSearchResult();
 
 	if (AtRange == 0 || (GridX * GridY) <= 0)
 		return FSearchResult();
 
-	// No need to create this outside of the function. No one should use this.
-	struct FANode
-	{
-	public:
-
-		uint32 Closed : 1;
-		int32 OpenSetIndex = -1;
-		int32 parent = -1;
-		int32 parentCount = 0;
-		float TotalCost = 0.0f;
-		float TraversalCost = 0.0f;
-		float HeuristicCost = 0.0f;
-		float NodeCostCount = 0.0f;
-		float NodeCost;
-
-		FANode()
-			: Closed(false)
-			, NodeCost(1.0f)
-		{}
-	};
+	// Keeps the number of buckets bounded for very large ranges.
+	static constexpr int32 MaxBuckets = 4096;
 
 	FSearchResult Result;
 
 	float DefaultNodeCost = 1.0f;
+	const float RangeLimit = Preferences.bOverrideNodeCostToOne ? AtRange : AtRange * DefaultNodeCost;
 
-	TMap<int32, FTileNeighborCost> closedSet;
-	TMap<int32, FTileNeighborCost> openSet;
-	TMap<int32, FTileNeighborCost> FinalSet;
-	TMap<int32, FANode>	Node;
+	// Uniform cost expansion bounded by the range.
+	// NodeCostCount holds the cost from the start, nodes that get cheaper after they were expanded are expanded again.
+	FScopedGridSearchScratch Scratch(GridX * GridY);
+	const float BucketWidth = FMath::Max(1.0f, RangeLimit / MaxBuckets);
+	Scratch->Buckets.Reset(BucketWidth, FMath::Max(FMath::FloorToInt32(RangeLimit / BucketWidth), 0) + 1);
 
-	TArray<int32> ObstacleIndexes;
+	Scratch->Visit(StartIndex);
+	Scratch->Buckets.Push(StartIndex, 0.0f);
 
-	openSet.Add(StartIndex, 1.0f);
+	const FGridAdjacency& Adjacency = KernelType::GetAdjacency(*this);
 
-	bool loop = true;
-	bool pass = false;
-	bool wayout = false;
+	TArray<int32> ObstacleIndexes;
 
 	bool bForceFail = false;
 
-	while (loop)
+	int32 CurrentIndex = -1;
+	float CurrentCost = 0.0f;
+	while (Scratch->Buckets.Pop(CurrentIndex, CurrentCost))
 	{
-		loop = false;
-		pass = false;
-		wayout = false;
-		FTileNeighborResult NeighborIndexes_Pass1;
-		if (closedSet.Num() == 0)
-		{
-			NeighborIndexes_Pass1 = GetNeighborIndexes(StartIndex, -1, Preferences);
-			if (NeighborIndexes_Pass1.Neighbors.Num() == 0)
-				break;
+		FGridSearchNode& CurrentNode = Scratch->Visit(CurrentIndex);
+		if (CurrentNode.bClosed || CurrentCost != CurrentNode.NodeCostCount)
+			continue;
 
-			if (Preferences.bRecordObstacleIndexes)
-				ObstacleIndexes.Append(NeighborIndexes_Pass1.ObstacleIndexes);
-		}
-		for (const auto& inx : closedSet.Num() == 0 ? NeighborIndexes_Pass1.Neighbors : closedSet)
-		{
-			FTileNeighborResult NeighborIndexes_Pass2;
-			if (closedSet.Num() == 0)
-			{
-				NeighborIndexes_Pass2 = GetNeighborIndexes(StartIndex, -1, Preferences);
-				if (NeighborIndexes_Pass2.Neighbors.Num() == 0)
-				{
-					continue;
-				}
-				else
-				{
-					loop = true;
-				}
-			}
-			else
-			{
-				NeighborIndexes_Pass2 = GetNeighborIndexes(inx.Key, -1, Preferences);
-				if (NeighborIndexes_Pass2.Neighbors.Num() == 0)
-				{
-					continue;
-				}
-				else
-				{
-					loop = true;
-				}
-			}
+		CurrentNode.bClosed = true;
 
-			if (Preferences.bRecordObstacleIndexes)
-				ObstacleIndexes.Append(NeighborIndexes_Pass2.ObstacleIndexes);
+		const int32 ParentCount = CurrentNode.ParentCount;
 
-			for (const auto& loc : NeighborIndexes_Pass2.Neighbors)
+		KernelType::ForEach(Adjacency, CurrentIndex, [&](int32 NeighborIndex, ENeighborDirection Direction) -> bool
 			{
-				if (loc.Key != StartIndex)
+				const FGridStepAccess Access = Policy.GetAccess(CurrentIndex, NeighborIndex, -1, Direction);
+				if (!Access.bAccess)
 				{
-					auto& NodeFragment = Node.FindOrAdd(loc.Key);
+					if (Preferences.bRecordObstacleIndexes)
+						ObstacleIndexes.Add(NeighborIndex);
+					return true;
+				}
 
-					float NodeCost = loc.Value.NodeCost;
-					NodeFragment.NodeCost = NodeCost;
+				if (NeighborIndex == StartIndex)
+					return true;
 
-					float tentativeCost = Node.FindOrAdd(inx.Key).NodeCostCount + (NodeFragment.NodeCost * loc.Value.NodeCostScale);
+				const float NodeCostCount = CurrentCost + (Preferences.bOverrideNodeCostToOne ? 1.0f : Access.NodeCost * Access.NodeCostScale);
 
-					if (tentativeCost < NodeFragment.NodeCostCount || !openSet.Contains(loc.Key))
-					{
-						NodeFragment.parent = closedSet.Num() == 0 ? StartIndex : inx.Key;
-						NodeFragment.NodeCostCount = Preferences.bOverrideNodeCostToOne ? Node.FindOrAdd(NodeFragment.parent).NodeCostCount + 1
-							: (NodeCost * loc.Value.NodeCostScale) + Node.FindOrAdd(NodeFragment.parent).NodeCostCount;
-						loop = true;
-						pass = true;
-
-						bool bSkip = false;
-						if (Preferences.TotalNodeCostLimit >= 0 && NodeFragment.NodeCostCount > Preferences.TotalNodeCostLimit)
-						{
-							bSkip = true;
-
-							if (Preferences.bFailIfTotalNodeCostExceeded)
-							{
-								bForceFail = true;
-								loop = false;
-								pass = false;
-								wayout = false;
-							}
-						}
+				const FGridSearchNode* Reached = Scratch->Find(NeighborIndex);
+				if (Reached && NodeCostCount >= Reached->NodeCostCount)
+					return true;
 
-						if (NodeFragment.NodeCostCount <= (Preferences.bOverrideNodeCostToOne ? AtRange : AtRange * DefaultNodeCost) && !bSkip)
-						{
-							wayout = true;
-							NodeFragment.parentCount = Node.FindOrAdd(NodeFragment.parent).parentCount + 1;
-							openSet.FindOrAdd(loc.Key) = (loc.Key, NodeCost);
-							FinalSet.FindOrAdd(loc.Key) = (loc.Key, NodeCost);
-						}
-					}
-					else if (!pass)
-					{
-						loop = false;
-					}
+				if (Preferences.TotalNodeCostLimit >= 0 && NodeCostCount > Preferences.TotalNodeCostLimit)
+				{
+					if (Preferences.bFailIfTotalNodeCostExceeded)
+						bForceFail = true;
+					return true;
 				}
-			}
-		}
 
-		closedSet.Empty();
-		closedSet = FinalSet;
-		FinalSet.Empty();
+				if (NodeCostCount > RangeLimit)
+					return true;
 
-		if (!wayout)
-			break;
+				if (!Reached)
+					Scratch->VisitOrder.Add(NeighborIndex);
+
+				FGridSearchNode& NextNode = Scratch->Visit(NeighborIndex);
+				NextNode.bClosed = false;
+				NextNode.Parent = CurrentIndex;
+				NextNode.ParentCount = ParentCount + 1;
+				NextNode.NodeCost = Access.NodeCost;
+				NextNode.NodeCostCount = NodeCostCount;
+
+				Scratch->Buckets.Push(NeighborIndex, NodeCostCount);
+				return true;
+			});
 	}
 
-	if (openSet.Num() > 1)
+	if (Scratch->VisitOrder.Num() > 0)
 	{
 		Result.ResultState = ESearchResult::SearchSuccess;
 	}
@@ -859,15 +1181,13 @@ FSearchResult ADsGrid::PathSearchAtRange(int32 StartIndex, int32 AtRange, FAStar
 		return Result;
 	}
 
-	for (const auto& inx : openSet)
+	for (const int32 Index : Scratch->VisitOrder)
 	{
-		if (inx.Key != StartIndex)
-		{
-			Result.PathResults.Add(Instances[inx.Key].Location);
-			Result.Parents.Add(inx.Key, Node[inx.Key].parent);
-			Result.PathIndexes.Add(inx.Key);
-			Result.PathCosts.Add(inx.Key, inx.Value.NodeCost);
-		}
+		const FGridSearchNode* Node = Scratch->Find(Index);
+		Result.PathResults.Add(GetTileLocation(Index));
+		Result.Parents.Add(Index, Node->Parent);
+		Result.PathIndexes.Add(Index);
+		Result.PathCosts.Add(Index, Node->NodeCost);
 	}
 
 	if (Preferences.bRecordObstacleIndexes)
@@ -936,7 +1256,7 @@ FSearchResult ADsGrid::RetracePath(int32 StartIndex, int32 EndIndex, FSearchResu
 					return SearchResult;
 				}
 
-				FVector currentVector = Instances[currentIndex].Location;
+				FVector currentVector = GetTileLocation(currentIndex);
 				SearchResult.PathResults.Insert(currentVector, 0);
 				SearchResult.PathIndexes.Insert(currentIndex, 0);
 				SearchResult.PathLength = SearchResult.PathLength + 1;
@@ -1084,7 +1404,15 @@ TArray<int32> ADsGrid::GetNeighborTilesAsArray(int32 Index, bool bBlockBorder) c
 	if (!IsValidIndex(Index))
 		return TArray<int32>();
 
-	return GetNeighborTiles(Index, bBlockBorder).GetAllNodesAsArray(GridType, bSquareGridDiagonalAllowed);
+	const FGridAdjacency& Adjacency = GetAdjacency(bBlockBorder);
+	if (Adjacency.Num() != Tiles.Num())
+		return GetNeighborTiles(Index, bBlockBorder).GetAllNodesAsArray(GridType, bSquareGridDiagonalAllowed);
+
+	TArray<int32> Neighbors;
+	Neighbors.Reserve(Adjacency.End(Index) - Adjacency.Begin(Index));
+	for (int32 Edge = Adjacency.Begin(Index); Edge < Adjacency.End(Index); Edge++)
+		Neighbors.Add(Adjacency.GetNeighbor(Index, Edge));
+	return Neighbors;
 }
 
 TArray<int32> ADsGrid::GetNeighborTilesInRangeAsArray(int32 Index, int32 Range, bool bBlockBorder) const
@@ -1204,140 +1532,37 @@ int32 ADsGrid::GetNeighborTileIndex(int32 Index, ENeighborDirection Direction, E
 *	EAST and WEST SQUARE Grid Only
 *   To Do: Change return val to struct. Return obstacle indices.
 */
-FTileNeighborResult ADsGrid::GetNeighborIndexes(int32 Index, int32 EndIndex, FAStarPreferences Preferences) const
+FTileNeighborResult ADsGrid::GetNeighborIndexes(int32 Index, int32 EndIndex, const FAStarPreferences& Preferences) const
+{
+	return GetNeighborIndexesWithContext(Index, EndIndex, MakeQueryContext(Preferences));
+}
+
+FTileNeighborResult ADsGrid::GetNeighborIndexesWithContext(int32 Index, int32 EndIndex, const FGridQueryContext& Context) const
 {
 	SCOPE_CYCLE_COUNTER(STAT_GetNeighborIndexes);
 
 	FTileNeighborResult Result;
-	FNeighbors Neighbors = GetNeighborTiles(Index, Preferences.bBlockBorder);
-
-	FNodeAttribute Access;
 
-	if (Neighbors.EAST < (GridX * GridY) && Neighbors.EAST >= 0 && GridType == EGridType::Square)
-	{
-		Access = NodeBehavior(Index, Neighbors.EAST, EndIndex, Preferences, ENeighborDirection::EAST);
-		if (Access.bAccess)
-		{
-			Result.Neighbors.Add(Neighbors.EAST, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
-		}
-		else if (Preferences.bRecordObstacleIndexes)
-		{
-			Result.ObstacleIndexes.Add(Neighbors.EAST);
-		}
-	}
-	if (Neighbors.WEST < (GridX * GridY) && Neighbors.WEST >= 0 && GridType == EGridType::Square)
-	{
-		Access = NodeBehavior(Index, Neighbors.WEST, EndIndex, Preferences, ENeighborDirection::WEST);
-		if (Access.bAccess)
-		{
-			Result.Neighbors.Add(Neighbors.WEST, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
-		}
-		else if (Preferences.bRecordObstacleIndexes)
-		{
-			Result.ObstacleIndexes.Add(Neighbors.WEST);
-		}
-	}
-	if (Neighbors.SOUTH < (GridX * GridY) && Neighbors.SOUTH >= 0)
-	{
-		Access = NodeBehavior(Index, Neighbors.SOUTH, EndIndex, Preferences, ENeighborDirection::SOUTH);
-		if (Access.bAccess)
-		{
-			Result.Neighbors.Add(Neighbors.SOUTH, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
-		}
-		else if (Preferences.bRecordObstacleIndexes)
-		{
-			Result.ObstacleIndexes.Add(Neighbors.SOUTH);
-		}
-	}
-	if (Neighbors.NORTH < (GridX * GridY) && Neighbors.NORTH >= 0)
-	{
-		Access = NodeBehavior(Index, Neighbors.NORTH, EndIndex, Preferences, ENeighborDirection::NORTH);
-		if (Access.bAccess)
-		{
-			Result.Neighbors.Add(Neighbors.NORTH, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
-		}
-		else if (Preferences.bRecordObstacleIndexes)
-		{
-			Result.ObstacleIndexes.Add(Neighbors.NORTH);
-		}
-	}
+	if (!IsValidIndex(Index))
+		return Result;
 
-	if (Neighbors.SOUTHEAST < (GridX * GridY) && Neighbors.SOUTHEAST >= 0)
-	{
-		Access = NodeBehavior(Index, Neighbors.SOUTHEAST, EndIndex, Preferences, ENeighborDirection::SOUTH_EAST);
-		if (Access.bAccess)
+	const FGridAdjacency& Adjacency = GetAdjacency(Context.Preferences.bBlockBorder);
+	DispatchGridCostPolicy(*this, Context, [&](auto Policy)
 		{
-			if (bSquareGridDiagonalAllowed && GridType == EGridType::Square)
+			for (int32 Edge = Adjacency.Begin(Index); Edge < Adjacency.End(Index); Edge++)
 			{
-				Result.Neighbors.Add(Neighbors.SOUTHEAST, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
-			}
-			else if (GridType == EGridType::Hex)
-			{
-				Result.Neighbors.Add(Neighbors.SOUTHEAST, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
-			}
-		}
-		else if (Preferences.bRecordObstacleIndexes)
-		{
-			Result.ObstacleIndexes.Add(Neighbors.SOUTHEAST);
-		}
-	}
-	if (Neighbors.SOUTHWEST < (GridX * GridY) && Neighbors.SOUTHWEST >= 0)
-	{
-		Access = NodeBehavior(Index, Neighbors.SOUTHWEST, EndIndex, Preferences, ENeighborDirection::SOUTH_WEST);
-		if (Access.bAccess)
-		{
-			if (bSquareGridDiagonalAllowed && GridType == EGridType::Square)
-			{
-				Result.Neighbors.Add(Neighbors.SOUTHWEST, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
-			}
-			else if (GridType == EGridType::Hex)
-			{
-				Result.Neighbors.Add(Neighbors.SOUTHWEST, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
-			}
-		}
-		else if (Preferences.bRecordObstacleIndexes)
-		{
-			Result.ObstacleIndexes.Add(Neighbors.SOUTHWEST);
-		}
-	}
-	if (Neighbors.NORTHWEST < (GridX * GridY) && Neighbors.NORTHWEST >= 0)
-	{
-		Access = NodeBehavior(Index, Neighbors.NORTHWEST, EndIndex, Preferences, ENeighborDirection::NORTH_WEST);
-		if (Access.bAccess)
-		{
-			if (bSquareGridDiagonalAllowed && GridType == EGridType::Square)
-			{
-				Result.Neighbors.Add(Neighbors.NORTHWEST, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
-			}
-			else if (GridType == EGridType::Hex)
-			{
-				Result.Neighbors.Add(Neighbors.NORTHWEST, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
-			}
-		}
-		else if (Preferences.bRecordObstacleIndexes)
-		{
-			Result.ObstacleIndexes.Add(Neighbors.NORTHWEST);
-		}
-	}
-	if (Neighbors.NORTHEAST < (GridX * GridY) && Neighbors.NORTHEAST >= 0)
-	{
-		Access = NodeBehavior(Index, Neighbors.NORTHEAST, EndIndex, Preferences, ENeighborDirection::NORTH_EAST);
-		if (Access.bAccess)
-		{
-			if (bSquareGridDiagonalAllowed && GridType == EGridType::Square)
-			{
-				Result.Neighbors.Add(Neighbors.NORTHEAST, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
-			}
-			else if (GridType == EGridType::Hex)
-			{
-				Result.Neighbors.Add(Neighbors.NORTHEAST, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
+				const int32 Neighbor = Adjacency.GetNeighbor(Index, Edge);
+				const FGridStepAccess Access = Policy.GetAccess(Index, Neighbor, EndIndex, Adjacency.Directions[Edge]);
+				if (Access.bAccess)
+				{
+					Result.Neighbors.Add(Neighbor, FTileNeighborCost(Access.NodeCost, Access.NodeCostScale));
+				}
+				else if (Context.Preferences.bRecordObstacleIndexes)
+				{
+					Result.ObstacleIndexes.Add(Neighbor);
+				}
 			}
-		}
-		else if (Preferences.bRecordObstacleIndexes)
-		{
-			Result.ObstacleIndexes.Add(Neighbors.NORTHEAST);
-		}
-	}
+		});
 
 	return Result;
 }
@@ -1346,7 +1571,28 @@ FNodeAttribute ADsGrid::NodeBehavior(int32 CurrentIndex, int32 NeighborIndex, in
 {
 	SCOPE_CYCLE_COUNTER(STAT_AccessNode);
 
-	return Instances[CurrentIndex].NodeAttribute;
+	if (!IsValidIndex(NeighborIndex))
+		return FNodeAttribute(false, 9999999.0f, ETileType::Undefined);
+
+	return GetTileData().GetAttribute(NeighborIndex);
+}
+
+bool ADsGrid::HasCustomNodeBehavior() const
+{
+	// NodeBehavior is not a Blueprint event, only a native class between this one and ADsGrid can override it
+	const UClass* NativeClass = GetClass();
+	while (NativeClass && !NativeClass->HasAnyClassFlags(CLASS_Native))
+		NativeClass = NativeClass->GetSuperClass();
+
+	return NativeClass != ADsGrid::StaticClass();
+}
+
+FNodeAttribute ADsGrid::NodeBehaviorWithContext(int32 CurrentIndex, int32 NeighborIndex, int32 EndIndex, const FGridQueryContext& Context, ENeighborDirection Direction) const
+{
+	if (!IsValidIndex(NeighborIndex) || Context.IsTileExcluded(NeighborIndex, GetTileData().Type[NeighborIndex]))
+		return FNodeAttribute(false, 9999999.0f, ETileType::Undefined);
+
+	return NodeBehavior(CurrentIndex, NeighborIndex, EndIndex, Context.Preferences, Direction);
 }
 
 ENeighborDirection ADsGrid::GetNodeDirection(int32 CurrentIndex, int32 NextIndex) const
@@ -1381,8 +1627,9 @@ bool ADsGrid::SetTileType(int32 Index, ETileType NewTileType)
 {
 	if (!IsValidIndex(Index))
 		return false;
-	Instances[Index].NodeAttribute.TileType = NewTileType;
-	OnTileAttributeChanged(Instances[Index]);
+	Tiles.Type[Index] = NewTileType;
+	NotifyTileChanged(Index);
+	OnTileAttributeChanged(GetNode(Index));
 	return true;
 }
 
@@ -1390,8 +1637,9 @@ bool ADsGrid::SetTileCost(int32 Index, float NewNodeCost)
 {
 	if (!IsValidIndex(Index))
 		return false;
-	Instances[Index].NodeAttribute.NodeCost = NewNodeCost;
-	OnTileAttributeChanged(Instances[Index]);
+	Tiles.Cost[Index] = NewNodeCost;
+	NotifyTileChanged(Index);
+	OnTileAttributeChanged(GetNode(Index));
 	return true;
 }
 
@@ -1399,8 +1647,9 @@ bool ADsGrid::SetTileAccess(int32 Index, bool bNewAccess)
 {
 	if (!IsValidIndex(Index))
 		return false;
-	Instances[Index].NodeAttribute.bAccess = bNewAccess;
-	OnTileAttributeChanged(Instances[Index]);
+	Tiles.Access[Index] = bNewAccess;
+	NotifyTileChanged(Index);
+	OnTileAttributeChanged(GetNode(Index));
 	return true;
 }
 
@@ -1416,14 +1665,52 @@ TArray<int32> ADsGrid::GetTileIndicesWithBox(FVector Center, FVector Extent) con
 	return GetInstancesOverlappingBox(Box);
 }
 
+const FGridTileData& ADsGrid::GetScopedTileData() const
+{
+	const FGridTileData* ReadView = FGridReadScope::Find(this);
+	return ReadView ? *ReadView : Tiles;
+}
+
+FGridQueryService& ADsGrid::GetQueryService() const
+{
+	check(IsInGameThread());
+
+	if (!QueryService.IsValid())
+		QueryService = MakeShared<FGridQueryService>(*this);
+	return *QueryService;
+}
+
 bool ADsGrid::IsValidIndex(int32 Index) const
 {
-	return Instances.Contains(Index);
+	return Index >= 0 && Index < Tiles.Num();
 }
 
 FVector ADsGrid::GetTileLocation(int32 Index) const
 {
-	return GetTile(Index).Location;
+	if (Tiles.Num() == 0)
+		return FVector::ZeroVector;
+
+	Index = FMath::Clamp(Index, 0, Tiles.Num() - 1);
+
+	const FVector2D Step = GetTileStep();
+	const int32 Column = GetIndexColumn(Index);
+	const int32 Row = GetIndexRow(Index);
+
+	FVector NodeLoc = FVector::ZeroVector;
+
+	switch (GridType)
+	{
+	case EGridType::Square:
+		NodeLoc.X = Column * Step.X;
+		NodeLoc.Y = Row * Step.Y;
+		break;
+	case EGridType::Hex:
+		NodeLoc.X = ((Row % 2) * (Step.X / 2)) + (Column * Step.X);
+		NodeLoc.Y = Row * (Step.Y * 0.75);
+		break;
+	}
+
+	return FVector(GridOrigin.X + NodeLoc.X * TileScale.X, GridOrigin.Y + NodeLoc.Y * TileScale.Y, GetTileData().Z[Index]);
 }
 
 FBox ADsGrid::GetTileBox(int32 Index) const
@@ -1438,10 +1725,11 @@ bool ADsGrid::SetTileAttribute(int32 Index, ETileType NewTileType, float NewNode
 	if (!IsValidIndex(Index))
 		return false;
 
-	Instances[Index].NodeAttribute.TileType = NewTileType;
-	Instances[Index].NodeAttribute.NodeCost = NewNodeCost;
-	Instances[Index].NodeAttribute.bAccess = bNewAccess;
-	OnTileAttributeChanged(Instances[Index]);
+	Tiles.Type[Index] = NewTileType;
+	Tiles.Cost[Index] = NewNodeCost;
+	Tiles.Access[Index] = bNewAccess;
+	NotifyTileChanged(Index);
+	OnTileAttributeChanged(GetNode(Index));
 	return true;
 }
 
@@ -1450,8 +1738,9 @@ bool ADsGrid::SetTileAttributeByNode(int32 Index, FNodeAttribute NewProperty)
 	if (!IsValidIndex(Index))
 		return false;
 
-	Instances[Index].NodeAttribute = NewProperty;
-	OnTileAttributeChanged(Instances[Index]);
+	Tiles.SetAttribute(Index, NewProperty);
+	NotifyTileChanged(Index);
+	OnTileAttributeChanged(GetNode(Index));
 	return true;
 }
 
@@ -1461,9 +1750,10 @@ bool ADsGrid::SetTilePropertyMap(TMap<int32, FNodeAttribute> NewNodeProperties)
 		return false;
 	for (const auto& Node : NewNodeProperties)
 	{
-		if (Instances.Contains(Node.Key))
+		if (IsValidIndex(Node.Key))
 		{
-			Instances[Node.Key].NodeAttribute = Node.Value;
+			Tiles.SetAttribute(Node.Key, Node.Value);
+			NotifyTileChanged(Node.Key);
 		}
 	}
 	OnTilePropertyMapSet();
@@ -1474,7 +1764,8 @@ bool ADsGrid::SetTileZ(int32 Index, float Z)
 {
 	if (!IsValidIndex(Index))
 		return false;
-	Instances[Index].Location.Z = Z;
+	Tiles.Z[Index] = Z;
+	NotifyTileChanged(Index);
 
 	return true;
 }
@@ -1503,11 +1794,71 @@ int32 ADsGrid::GetIndexColumn(int32 Index) const
 	return -1;
 }
 
+int32 ADsGrid::GetTileIndexAt(int32 Column, int32 Row) const
+{
+	if (Column < 0 || Column >= GridX || Row < 0 || Row >= GridY)
+		return -1;
+
+	return TileOrder == EGridTileOrder::RowMajor ? (Row * GridX) + Column : (Column * GridY) + Row;
+}
+
 ETileType ADsGrid::GetTileType(int32 Index) const
 {
 	if (!IsValidIndex(Index))
 		return ETileType::Undefined;
-	return Instances[Index].NodeAttribute.TileType;
+	return GetTileData().Type[Index];
+}
+
+template<typename FunctionType>
+void ADsGrid::ForEachTileInBounds(const FVector& BoundsMin, const FVector& BoundsMax, FunctionType&& Function) const
+{
+	const FVector2D Step = GetTileStep();
+	const double PitchX = Step.X * TileScale.X;
+	const double PitchY = (GridType == EGridType::Hex ? Step.Y * 0.75 : Step.Y) * TileScale.Y;
+
+	if (Tiles.Num() == 0 || FMath::IsNearlyZero(PitchX) || FMath::IsNearlyZero(PitchY))
+		return;
+
+	const FVector Extent = TileBound.GetExtent();
+	const double ExtentX = FMath::Abs(Extent.X * TileScale.X);
+	const double ExtentY = FMath::Abs(Extent.Y * TileScale.Y);
+
+	// Solves Origin + i * Pitch in [Lo, Hi] for i and clamps it to [0, Count)
+	auto GetRange = [](double Lo, double Hi, double Origin, double Pitch, int32 Count, int32& OutFirst, int32& OutLast) -> bool
+		{
+			double First = (Lo - Origin) / Pitch;
+			double Last = (Hi - Origin) / Pitch;
+			if (First > Last)
+				Swap(First, Last);
+
+			First = FMath::Clamp(First, -1.0, (double)Count);
+			Last = FMath::Clamp(Last, -1.0, (double)Count);
+
+			OutFirst = FMath::Max(FMath::CeilToInt32(First - KINDA_SMALL_NUMBER), 0);
+			OutLast = FMath::Min(FMath::FloorToInt32(Last + KINDA_SMALL_NUMBER), Count - 1);
+			return OutFirst <= OutLast;
+		};
+
+	int32 FirstRow = 0;
+	int32 LastRow = 0;
+	if (!GetRange(BoundsMin.Y - ExtentY, BoundsMax.Y + ExtentY, GridOrigin.Y, PitchY, GridY, FirstRow, LastRow))
+		return;
+
+	for (int32 Row = FirstRow; Row <= LastRow; Row++)
+	{
+		// Odd hex rows are shifted by half a tile
+		const double RowOriginX = GridOrigin.X + ((GridType == EGridType::Hex && (Row % 2) != 0) ? PitchX * 0.5 : 0.0);
+
+		int32 FirstColumn = 0;
+		int32 LastColumn = 0;
+		if (!GetRange(BoundsMin.X - ExtentX, BoundsMax.X + ExtentX, RowOriginX, PitchX, GridX, FirstColumn, LastColumn))
+			continue;
+
+		for (int32 Column = FirstColumn; Column <= LastColumn; Column++)
+		{
+			Function(GetTileIndexAt(Column, Row));
+		}
+	}
 }
 
 TArray<int32> ADsGrid::GetInstancesOverlappingBox(const FBox& Box) const
@@ -1516,14 +1867,14 @@ TArray<int32> ADsGrid::GetInstancesOverlappingBox(const FBox& Box) const
 	CellBound.Min = TileBound.Min * FVector(TileScale, 1.0f);
 	CellBound.Max = TileBound.Max * FVector(TileScale, 1.0f);
 	TArray<int32> indices;
-	for (const auto& Instance : Instances)
-	{
-		CellBound = CellBound.MoveTo(Instance.Value.Location);
-		if (Box.Intersect(CellBound))
+	ForEachTileInBounds(Box.Min, Box.Max, [&](int32 Index)
 		{
-			indices.Add(Instance.Key);
-		}
-	}
+			CellBound = CellBound.MoveTo(GetTileLocation(Index));
+			if (Box.Intersect(CellBound))
+			{
+				indices.Add(Index);
+			}
+		});
 	return indices;
 }
 
@@ -1534,99 +1885,116 @@ TArray<int32> ADsGrid::GetInstancesOverlappingSphere(const FVector& Center, cons
 	CellBound.Max = TileBound.Max * FVector(TileScale, 1.0f);
 	FSphere Sphere(Center, Radius);
 	TArray<int32> indices;
-	for (const auto& Instance : Instances)
-	{
-		CellBound = CellBound.MoveTo(Instance.Value.Location);
-		if (FMath::SphereAABBIntersection(Sphere, CellBound))
+	ForEachTileInBounds(Center - FVector(Radius), Center + FVector(Radius), [&](int32 Index)
 		{
-			indices.Add(Instance.Key);
-		}
-	}
+			CellBound = CellBound.MoveTo(GetTileLocation(Index));
+			if (FMath::SphereAABBIntersection(Sphere, CellBound))
+			{
+				indices.Add(Index);
+			}
+		});
 	return indices;
 }
 
 int32 ADsGrid::GetTileIndex(FVector Point) const
 {
-	FBox CellBound = GetTileBound();
-	CellBound.Min = TileBound.Min * FVector(TileScale, 1.0f);
-	CellBound.Max = TileBound.Max * FVector(TileScale, 1.0f);
-	for (const auto& Instance : Instances)
-	{
-		CellBound = CellBound.MoveTo(Instance.Value.Location);
-		if (CellBound.IsInsideXY(Point))
-		{
-			return Instance.Key;
-		}
-	}
-	return -1;
+	SCOPE_CYCLE_COUNTER(STAT_GetNodeIndex);
+
+	int32 Column = -1;
+	int32 Row = -1;
+	if (!GetNearestTileCoord(Point, Column, Row))
+		return -1;
+
+	const int32 Index = GetTileIndexAt(Column, Row);
+	if (Index == -1 || !IsInsideTileXY(Index, Point))
+		return -1;
+
+	return Index;
 }
 
-void ADsGrid::AddInstance(FVector Loc, FNodeAttribute NewNode)
+TArray<int32> ADsGrid::GetTileIndices(const TArray<FVector>& Points) const
 {
-	Instances.Add(Instances.Num(), FGridNode(Loc, NewNode));
+	TArray<int32> Indices;
+	Indices.SetNumUninitialized(Points.Num());
+	for (int32 i = 0; i < Points.Num(); i++)
+	{
+		Indices[i] = GetTileIndex(Points[i]);
+	}
+	return Indices;
 }
 
-void ADsGrid::CreateNewInstance(int32 Index, FNodeAttribute NewNode)
+bool ADsGrid::GetNearestTileCoord(const FVector& Point, int32& OutColumn, int32& OutRow) const
 {
-	const float boundX = TileBound.Max.X - TileBound.Min.X + TileOffset.X;
-	const float boundY = TileBound.Max.Y - TileBound.Min.Y - TileOffset.Y;
+	const FVector2D Step = GetTileStep();
+	if (Tiles.Num() == 0 || FMath::IsNearlyZero(Step.X * TileScale.X) || FMath::IsNearlyZero(Step.Y * TileScale.Y))
+		return false;
 
-	const FVector gridLoc = GetActorLocation();
-	FVector NodeLoc = FVector::ZeroVector;
+	// Tile centers are laid out as (Column * Step.X, Row * Step.Y) before scaling, see GetTileLocation
+	const double LocalX = (Point.X - GridOrigin.X) / (Step.X * TileScale.X);
+	const double LocalY = (Point.Y - GridOrigin.Y) / (Step.Y * TileScale.Y);
 
 	switch (GridType)
 	{
 	case EGridType::Square:
-	{
-		switch (TileOrder)
-		{
-		case EGridTileOrder::RowMajor:
-			NodeLoc.X = (Index % GridX) * boundX;
-			NodeLoc.Y = (Index / GridX) * boundY;
-			NodeLoc.Z = 0.0f;
-			break;
-		case EGridTileOrder::ColumnMajor:
-			NodeLoc.X = (Index / GridY) * boundX;
-			NodeLoc.Y = (Index % GridY) * boundY;
-			NodeLoc.Z = 0.0f;
-			break;
-		default:
-			break;
-		}
-	}
-	break;
+		OutColumn = FMath::RoundToInt32(LocalX);
+		OutRow = FMath::RoundToInt32(LocalY);
+		return true;
 	case EGridType::Hex:
 	{
-		switch (TileOrder)
-		{
-		case EGridTileOrder::RowMajor:
-			NodeLoc.X = (((Index / GridX) % 2) * (boundX / 2)) + ((Index % GridX) * boundX);
-			NodeLoc.Y = (Index / GridX) * (boundY * 0.75);
-			NodeLoc.Z = 0.0f;
-			break;
-		case EGridTileOrder::ColumnMajor:
-			NodeLoc.X = (((Index % GridY) % 2) * (boundX / 2)) + ((Index / GridY) * boundX);
-			NodeLoc.Y = (Index % GridY) * (boundY * 0.75);
-			NodeLoc.Z = 0.0f;
-			break;
-		default:
-			break;
-		}
+		// Rows are 0.75 tile apart and odd rows are shifted by half a tile (odd-r offset layout).
+		const double r = LocalY / 0.75;
+		const double q = LocalX - (r * 0.5);
+		const double s = -q - r;
+
+		int32 rq = FMath::RoundToInt32(q);
+		int32 rr = FMath::RoundToInt32(r);
+		const int32 rs = FMath::RoundToInt32(s);
+
+		const double dq = FMath::Abs(rq - q);
+		const double dr = FMath::Abs(rr - r);
+		const double ds = FMath::Abs(rs - s);
+
+		if (dq > dr && dq > ds)
+			rq = -rr - rs;
+		else if (dr > ds)
+			rr = -rq - rs;
+
+		OutRow = rr;
+		OutColumn = rq + ((rr - (rr & 1)) / 2);
+		return true;
 	}
-	break;
 	}
+	return false;
+}
+
+bool ADsGrid::IsInsideTileXY(int32 Index, const FVector& Point) const
+{
+	const FVector Center = GetTileLocation(Index);
+	const FVector Extent = TileBound.GetExtent();
+	return FMath::Abs(Point.X - Center.X) <= FMath::Abs(Extent.X * TileScale.X)
+		&& FMath::Abs(Point.Y - Center.Y) <= FMath::Abs(Extent.Y * TileScale.Y);
+}
 
-	AddInstance(gridLoc + ((NodeLoc * FVector(TileScale, 1.0f))), NewNode);
+FVector2D ADsGrid::GetTileStep() const
+{
+	return FVector2D(TileBound.Max.X - TileBound.Min.X + TileOffset.X, TileBound.Max.Y - TileBound.Min.Y - TileOffset.Y);
 }
 
 int32 ADsGrid::GetGridSize() const
 {
-	return Instances.Num();
+	return Tiles.Num();
 }
 
 void ADsGrid::ClearInstances()
 {
-	Instances.Empty();
+	BeginLayoutChange();
+
+	Tiles.Empty();
+	TileClasses.Empty();
+	BlockedAdjacency.Empty();
+	WrappedAdjacency.Empty();
+	BlockedPredecessors.Empty();
+	WrappedPredecessors.Empty();
 }
 
 FBox ADsGrid::GetTileBound() const
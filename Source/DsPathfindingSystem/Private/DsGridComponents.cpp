@@ -0,0 +1,306 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#include "DsGridComponents.h"
+#include "DsGridSearch.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Grid~ComponentsBuild"), STAT_ComponentsBuild, STATGROUP_GRID);
+DECLARE_CYCLE_STAT(TEXT("Grid~ComponentsUpdate"), STAT_ComponentsUpdate, STATGROUP_GRID);
+
+void FGridComponents::Build(const ADsGrid& Grid)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ComponentsBuild);
+
+	const FGridTileData& TileData = Grid.GetTileData();
+	const int32 NumTiles = TileData.Num();
+
+	// The first label of a component is the index of the tile its flood started from
+	Labels.Init(INDEX_NONE, NumTiles);
+	Parents.SetNumUninitialized(NumTiles);
+	for (int32 Index = 0; Index < NumTiles; Index++)
+		Parents[Index] = Index;
+	Ranks.Init(0, NumTiles);
+
+	// Bands are index ranges, which are rows or columns depending on the tile order
+	constexpr int32 BandSize = 4096;
+	const int32 NumBands = FMath::DivideAndRoundUp(NumTiles, BandSize);
+	TArray<TArray<TPair<int32, int32>>> BandLinks;
+	BandLinks.SetNum(NumBands);
+
+	ParallelFor(NumBands, [&](int32 Band)
+		{
+			const int32 BandBegin = Band * BandSize;
+			const int32 BandEnd = FMath::Min(BandBegin + BandSize, NumTiles);
+			TArray<int32> Stack;
+
+			for (int32 Seed = BandBegin; Seed < BandEnd; Seed++)
+			{
+				if (!TileData.Access[Seed] || Labels[Seed] != INDEX_NONE)
+					continue;
+
+				Labels[Seed] = Seed;
+				Stack.Add(Seed);
+				while (Stack.Num() > 0)
+				{
+					const int32 Current = Stack.Pop(EAllowShrinking::No);
+					ForEachLink(Grid, Current, [&](int32 Next)
+						{
+							if (!TileData.Access[Next])
+								return;
+
+							if (Next < BandBegin || Next >= BandEnd)
+							{
+								// Every link is seen from both bands, the later band keeps it
+								if (Next < BandBegin)
+									BandLinks[Band].Add(TPair<int32, int32>(Current, Next));
+								return;
+							}
+
+							if (Labels[Next] == INDEX_NONE)
+							{
+								Labels[Next] = Seed;
+								Stack.Add(Next);
+							}
+						});
+				}
+			}
+		});
+
+	for (const TArray<TPair<int32, int32>>& Links : BandLinks)
+	{
+		for (const TPair<int32, int32>& Link : Links)
+			Union(Labels[Link.Key], Labels[Link.Value]);
+	}
+
+	// Flatten the forest so lookups take one step
+	for (int32 Label = 0; Label < NumTiles; Label++)
+		Parents[Label] = FindRoot(Label);
+}
+
+int32 FGridComponents::Union(int32 First, int32 Second)
+{
+	int32 FirstRoot = FindRoot(First);
+	int32 SecondRoot = FindRoot(Second);
+	if (FirstRoot == SecondRoot)
+		return FirstRoot;
+
+	if (Ranks[FirstRoot] < Ranks[SecondRoot])
+		Swap(FirstRoot, SecondRoot);
+
+	Parents[SecondRoot] = FirstRoot;
+	if (Ranks[FirstRoot] == Ranks[SecondRoot])
+		Ranks[FirstRoot]++;
+	return FirstRoot;
+}
+
+void FGridComponents::UpdateTile(const ADsGrid& Grid, int32 Index)
+{
+	const bool bWalkable = Grid.GetTileData().Access[Index];
+	if (bWalkable == (Labels[Index] != INDEX_NONE))
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ComponentsUpdate);
+
+	if (bWalkable)
+	{
+		int32 Root = INDEX_NONE;
+		ForEachLink(Grid, Index, [&](int32 Next)
+			{
+				if (Labels[Next] != INDEX_NONE)
+					Root = Root == INDEX_NONE ? FindRoot(Labels[Next]) : Union(Root, Labels[Next]);
+			});
+		Labels[Index] = Root == INDEX_NONE ? AddLabel() : Root;
+	}
+	else
+	{
+		Labels[Index] = INDEX_NONE;
+
+		TArray<int32> Seeds;
+		ForEachLink(Grid, Index, [&](int32 Next)
+			{
+				if (Labels[Next] != INDEX_NONE)
+					Seeds.AddUnique(Next);
+			});
+
+		if (Seeds.Num() > 1)
+			SplitAround(Grid, Seeds);
+	}
+
+	// Every split adds labels, start over once the forest is mostly stale
+	if (Parents.Num() > Labels.Num() * 2 + 64)
+		Build(Grid);
+}
+
+void FGridComponents::SplitAround(const ADsGrid& Grid, const TArray<int32>& Seeds)
+{
+	const int32 NumSeeds = Seeds.Num();
+	FScopedGridSearchScratch Scratch(Labels.Num());
+
+	// Every seed floods its side breadth first, Visited doubles as its queue and Parent of a visited node names the seed.
+	// Floods that meet form a group. A group whose floods all ran out is cut off from the rest and gets a new label,
+	// the last open group keeps the old one. The work is bounded by the size of the smaller sides.
+	TArray<TArray<int32>> Visited;
+	Visited.SetNum(NumSeeds);
+	TArray<int32> Heads;
+	Heads.Init(0, NumSeeds);
+	TArray<int32> Groups;
+	TArray<bool> bClosed;
+	bClosed.Init(false, NumSeeds);
+
+	for (int32 Seed = 0; Seed < NumSeeds; Seed++)
+	{
+		Groups.Add(Seed);
+		Scratch->Visit(Seeds[Seed]).Parent = Seed;
+		Visited[Seed].Add(Seeds[Seed]);
+	}
+
+	auto FindGroup = [&Groups](int32 Seed)
+		{
+			while (Groups[Seed] != Seed)
+				Seed = Groups[Seed];
+			return Seed;
+		};
+
+	int32 NumOpen = NumSeeds;
+	while (NumOpen > 1)
+	{
+		for (int32 Seed = 0; Seed < NumSeeds; Seed++)
+		{
+			if (Heads[Seed] >= Visited[Seed].Num() || bClosed[FindGroup(Seed)])
+				continue;
+
+			const int32 Current = Visited[Seed][Heads[Seed]++];
+			ForEachLink(Grid, Current, [&](int32 Next)
+				{
+					if (Labels[Next] == INDEX_NONE)
+						return;
+
+					if (!Scratch->IsVisited(Next))
+					{
+						Scratch->Visit(Next).Parent = Seed;
+						Visited[Seed].Add(Next);
+						return;
+					}
+
+					const int32 Group = FindGroup(Seed);
+					const int32 OtherGroup = FindGroup(Scratch->Find(Next)->Parent);
+					if (Group != OtherGroup)
+					{
+						Groups[OtherGroup] = Group;
+						NumOpen--;
+					}
+				});
+		}
+
+		for (int32 Group = 0; Group < NumSeeds && NumOpen > 1; Group++)
+		{
+			if (FindGroup(Group) != Group || bClosed[Group])
+				continue;
+
+			bool bExhausted = true;
+			for (int32 Seed = 0; Seed < NumSeeds && bExhausted; Seed++)
+				bExhausted = FindGroup(Seed) != Group || Heads[Seed] >= Visited[Seed].Num();
+			if (!bExhausted)
+				continue;
+
+			const int32 Label = AddLabel();
+			for (int32 Seed = 0; Seed < NumSeeds; Seed++)
+			{
+				if (FindGroup(Seed) == Group)
+				{
+					for (const int32 Index : Visited[Seed])
+						Labels[Index] = Label;
+				}
+			}
+			bClosed[Group] = true;
+			NumOpen--;
+		}
+	}
+}
+
+bool FGridComponents::CanReach(const ADsGrid& Grid, int32 StartIndex, int32 EndIndex, bool bStopAtNeighborLocation) const
+{
+	TArray<int32> Sources;
+	if (Labels[StartIndex] != INDEX_NONE)
+	{
+		Sources.Add(GetComponent(StartIndex));
+	}
+	else
+	{
+		const FGridAdjacency& Adjacency = Grid.GetAdjacency(true);
+		for (int32 Edge = Adjacency.Begin(StartIndex); Edge < Adjacency.End(StartIndex); Edge++)
+		{
+			const int32 NeighborIndex = Adjacency.GetNeighbor(StartIndex, Edge);
+			if (Labels[NeighborIndex] != INDEX_NONE)
+				Sources.AddUnique(GetComponent(NeighborIndex));
+		}
+	}
+
+	if (!bStopAtNeighborLocation)
+		return Labels[EndIndex] != INDEX_NONE && Sources.Contains(GetComponent(EndIndex));
+
+	for (const int32 NeighborIndex : Grid.GetNeighborTilesAsArray(EndIndex, true))
+	{
+		if (NeighborIndex == StartIndex)
+			return true;
+		if (Labels[NeighborIndex] != INDEX_NONE && Sources.Contains(GetComponent(NeighborIndex)))
+			return true;
+	}
+	return false;
+}
+
+void ADsGrid::BuildComponents()
+{
+	if (Tiles.Num() == 0)
+	{
+		Components.Reset();
+		return;
+	}
+
+	TSharedPtr<FGridComponents> NewComponents = MakeShared<FGridComponents>();
+	NewComponents->Build(*this);
+	Components = NewComponents;
+}
+
+bool ADsGrid::AreConnected(int32 FirstIndex, int32 SecondIndex) const
+{
+	if (!IsValidIndex(FirstIndex) || !IsValidIndex(SecondIndex) || !Components.IsValid() || !Components->IsBuilt(Tiles.Num()))
+		return false;
+
+	const int32 Component = Components->GetComponent(FirstIndex);
+	return Component != INDEX_NONE && Component == Components->GetComponent(SecondIndex);
+}
+
+int32 ADsGrid::GetTileComponent(int32 Index) const
+{
+	if (!IsValidIndex(Index) || !Components.IsValid() || !Components->IsBuilt(Tiles.Num()))
+		return -1;
+
+	return Components->GetComponent(Index);
+}
+
+bool ADsGrid::IsGoalUnreachable(int32 StartIndex, int32 EndIndex, const FGridQueryContext& Context, bool bStopAtNeighborLocation) const
+{
+	const FAStarPreferences& Preferences = Context.Preferences;
+
+	// The labels model the live tiles over blocked borders. Obstacle recording and partial paths
+	// under a cost limit need the search to run, AlreadyAtGoal is left to the search as well.
+	if (!Components.IsValid()
+		|| !Components->IsBuilt(Tiles.Num())
+		|| &GetTileData() != &Tiles
+		|| HasCustomNodeBehavior()
+		|| !Preferences.bBlockBorder
+		|| Preferences.bRecordObstacleIndexes
+		|| (Preferences.TotalNodeCostLimit >= 0 && !Preferences.bFailIfTotalNodeCostExceeded)
+		|| !IsValidIndex(StartIndex)
+		|| !IsValidIndex(EndIndex)
+		|| StartIndex == EndIndex)
+		return false;
+
+	return !Components->CanReach(*this, StartIndex, EndIndex, bStopAtNeighborLocation);
+}
@@ -0,0 +1,90 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DsGrid.h"
+
+/*
+* Connected components of the walkable tiles over the blocked border adjacency, see ADsGrid::AreConnected.
+* Edges are followed in both directions, so two tiles in different components can never reach each other,
+* whatever the tile filters of a query. Tiles carry a label, labels are joined in a union-find forest:
+* making a tile walkable merges the components around it in O(1), blocking one searches from its neighbors
+* in lockstep until they meet again, and relabels the parts that got cut off.
+*/
+class FGridComponents
+{
+public:
+	/* Labels every walkable tile. Row bands are flood filled in parallel and joined along their borders. */
+	void Build(const ADsGrid& Grid);
+
+	FORCEINLINE bool IsBuilt(int32 NumTiles) const
+	{
+		return Labels.Num() == NumTiles && NumTiles > 0;
+	}
+
+	/* Call after the tile changed, does nothing if its access did not */
+	void UpdateTile(const ADsGrid& Grid, int32 Index);
+
+	/* Component of a walkable tile, INDEX_NONE for blocked tiles */
+	FORCEINLINE int32 GetComponent(int32 Index) const
+	{
+		const int32 Label = Labels[Index];
+		return Label == INDEX_NONE ? INDEX_NONE : FindRoot(Label);
+	}
+
+	/*
+	* False only if AStarSearch over the blocked border adjacency can not reach the goal.
+	* A blocked start leaves through its walkable neighbors, bStopAtNeighborLocation accepts any walkable neighbor of the end.
+	*/
+	bool CanReach(const ADsGrid& Grid, int32 StartIndex, int32 EndIndex, bool bStopAtNeighborLocation) const;
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Labels.GetAllocatedSize() + Parents.GetAllocatedSize() + Ranks.GetAllocatedSize();
+	}
+
+private:
+	FORCEINLINE int32 FindRoot(int32 Label) const
+	{
+		while (Parents[Label] != Label)
+			Label = Parents[Label];
+		return Label;
+	}
+
+	FORCEINLINE int32 AddLabel()
+	{
+		Ranks.Add(0);
+		return Parents.Add(Parents.Num());
+	}
+
+	/* Joins two components, returns the root of the result */
+	int32 Union(int32 First, int32 Second);
+
+	/* Calls Function for every tile with an edge to or from Index */
+	template<typename FunctionType>
+	static FORCEINLINE void ForEachLink(const ADsGrid& Grid, int32 Index, FunctionType&& Function)
+	{
+		const FGridAdjacency& Successors = Grid.GetAdjacency(true);
+		for (int32 Edge = Successors.Begin(Index); Edge < Successors.End(Index); Edge++)
+			Function(Successors.GetNeighbor(Index, Edge));
+
+		const FGridAdjacency& Predecessors = Grid.GetPredecessors(true);
+		for (int32 Edge = Predecessors.Begin(Index); Edge < Predecessors.End(Index); Edge++)
+			Function(Predecessors.GetNeighbor(Index, Edge));
+	}
+
+	/* Splits the component of Seeds after the tile between them was blocked */
+	void SplitAround(const ADsGrid& Grid, const TArray<int32>& Seeds);
+
+	/* Label per tile, INDEX_NONE if the tile is blocked */
+	TArray<int32> Labels;
+	/* Union-find forest over the labels, only written on the game thread so lookups can run on workers */
+	TArray<int32> Parents;
+	TArray<uint8> Ranks;
+};
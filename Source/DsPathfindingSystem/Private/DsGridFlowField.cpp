@@ -0,0 +1,257 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#include "DsGridFlowField.h"
+#include "DsGridSearch.h"
+
+DECLARE_CYCLE_STAT(TEXT("Grid~FlowFieldBuild"), STAT_FlowFieldBuild, STATGROUP_GRID);
+DECLARE_CYCLE_STAT(TEXT("Grid~FlowFieldSearch"), STAT_FlowFieldSearch, STATGROUP_GRID);
+
+FGridFlowField::FGridFlowField(const ADsGrid& Grid, int32 InGoalIndex, const FAStarPreferences& Preferences, bool bInStopAtNeighborLocation, EGridHeuristicFunction InHeuristicFunction)
+	: Context(Grid.MakeQueryContext(Preferences))
+	, GoalIndex(InGoalIndex)
+	, bStopAtNeighborLocation(bInStopAtNeighborLocation)
+	, HeuristicFunction(InHeuristicFunction)
+{
+	Build(Grid);
+}
+
+void FGridFlowField::Build(const ADsGrid& Grid)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlowFieldBuild);
+
+	const int32 NumTiles = Grid.GetGridSize();
+	CostToGoal.Init(MAX_flt, NumTiles);
+	Directions.Init(ENeighborDirection::None, NumTiles);
+
+	if (!Grid.IsValidIndex(GoalIndex))
+		return;
+
+	const bool bOverrideNodeCostToOne = Context.Preferences.bOverrideNodeCostToOne;
+	const FGridAdjacency& Predecessors = Grid.GetPredecessors(Context.Preferences.bBlockBorder);
+
+	FScopedGridSearchScratch Scratch(NumTiles);
+
+	DispatchGridCostPolicy(Grid, Context, [&](auto Policy)
+		{
+			if (bStopAtNeighborLocation)
+			{
+				for (const int32 Target : Grid.GetNeighborTilesAsArray(GoalIndex, Context.Preferences.bBlockBorder))
+				{
+					Scratch->Visit(Target);
+					Scratch->PushOpen(Target);
+				}
+			}
+			else if (Policy.GetAccess(-1, GoalIndex, GoalIndex).bAccess)
+			{
+				Scratch->Visit(GoalIndex);
+				Scratch->PushOpen(GoalIndex);
+			}
+
+			while (Scratch->HasOpen())
+			{
+				const int32 CurrentIndex = Scratch->PopOpen();
+				FGridSearchNode& CurrentNode = Scratch->Visit(CurrentIndex);
+				CurrentNode.bClosed = true;
+				CostToGoal[CurrentIndex] = CurrentNode.TraversalCost;
+
+				// Every predecessor can step into the current tile, the step pays for the current tile
+				const FVector CurrentLocation = Grid.GetTileLocation(CurrentIndex);
+				for (int32 Edge = Predecessors.Begin(CurrentIndex); Edge < Predecessors.End(CurrentIndex); Edge++)
+				{
+					const int32 PredecessorIndex = Predecessors.GetNeighbor(CurrentIndex, Edge);
+					FGridSearchNode& PredecessorNode = Scratch->Visit(PredecessorIndex);
+					if (PredecessorNode.bClosed)
+						continue;
+
+					const FGridStepAccess Access = Policy.GetAccess(PredecessorIndex, CurrentIndex, GoalIndex, Predecessors.Directions[Edge]);
+					if (!Access.bAccess)
+						continue;
+
+					const float TraversalCost = CurrentNode.TraversalCost + Grid.GetStepDistance(HeuristicFunction, Grid.GetTileLocation(PredecessorIndex), CurrentLocation)
+						+ (bOverrideNodeCostToOne ? 1.0f : Access.NodeCost * Access.NodeCostScale);
+
+					const bool bIsOpen = Scratch->IsOpen(PredecessorIndex);
+					if (bIsOpen && TraversalCost >= PredecessorNode.TraversalCost)
+						continue;
+
+					PredecessorNode.TraversalCost = TraversalCost;
+					PredecessorNode.TotalCost = TraversalCost;
+					PredecessorNode.Parent = CurrentIndex;
+					Directions[PredecessorIndex] = Predecessors.Directions[Edge];
+
+					if (bIsOpen)
+						Scratch->DecreaseKey(PredecessorIndex);
+					else
+						Scratch->PushOpen(PredecessorIndex);
+				}
+			}
+		});
+}
+
+int32 FGridFlowField::GetNextTile(const ADsGrid& Grid, int32 Index) const
+{
+	const ENeighborDirection Direction = GetDirection(Index);
+	if (Direction == ENeighborDirection::None)
+		return -1;
+
+	const FGridAdjacency& Adjacency = Grid.GetAdjacency(Context.Preferences.bBlockBorder);
+	for (int32 Edge = Adjacency.Begin(Index); Edge < Adjacency.End(Index); Edge++)
+	{
+		if (Adjacency.Directions[Edge] == Direction)
+			return Adjacency.GetNeighbor(Index, Edge);
+	}
+	return -1;
+}
+
+FSearchResult FGridFlowField::TracePath(const ADsGrid& Grid, int32 StartIndex) const
+{
+	if (!Grid.IsValidIndex(StartIndex) || !Grid.IsValidIndex(GoalIndex) || CostToGoal.Num() != Grid.GetGridSize())
+		return FSearchResult();
+
+	FSearchResult Result;
+	Result.EndPoint = GoalIndex;
+	Result.bStopAtNeighborLocation = bStopAtNeighborLocation;
+
+	if (StartIndex == GoalIndex || (bStopAtNeighborLocation && Grid.GetNeighborTilesAsArray(GoalIndex, Context.Preferences.bBlockBorder).Contains(StartIndex)))
+	{
+		Result.ResultState = ESearchResult::AlreadyAtGoal;
+		return Result;
+	}
+
+	if (!IsReachable(StartIndex))
+		return Result;
+
+	// Directions form a tree rooted at the targets, the guard only protects against a field read after a layout change
+	const bool bTraced = DispatchGridCostPolicy(Grid, Context, [&](auto Policy)
+		{
+			int32 Current = StartIndex;
+			for (int32 Step = 0; Directions[Current] != ENeighborDirection::None; Step++)
+			{
+				const int32 NextIndex = GetNextTile(Grid, Current);
+				if (NextIndex == -1 || Step >= CostToGoal.Num())
+					return false;
+
+				const float NodeCost = Context.Preferences.bOverrideNodeCostToOne ? 1.0f : Policy.GetAccess(Current, NextIndex, GoalIndex, Directions[Current]).NodeCost;
+
+				Result.PathResults.Add(Grid.GetTileLocation(NextIndex));
+				Result.PathIndexes.Add(NextIndex);
+				Result.PathLength = Result.PathLength + 1;
+				Result.TotalNodeCost += NodeCost;
+				Result.PathCosts.Add(NextIndex, NodeCost);
+				Result.Parents.Add(NextIndex, Current);
+
+				Current = NextIndex;
+			}
+			return true;
+		});
+
+	if (!bTraced)
+	{
+		Result = FSearchResult();
+		Result.EndPoint = GoalIndex;
+		Result.bStopAtNeighborLocation = bStopAtNeighborLocation;
+		return Result;
+	}
+	Result.ResultState = ESearchResult::SearchSuccess;
+
+	return Result;
+}
+
+TSharedPtr<const FGridFlowField> ADsGrid::FindOrBuildFlowField(int32 GoalIndex, const FAStarPreferences& Preferences, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction)
+{
+	check(IsInGameThread());
+
+	if (!IsValidIndex(GoalIndex))
+		return nullptr;
+
+	// NodeBehavior costs can change without a tile edit, the field is built for this call only and starts out stale
+	if (HasCustomNodeBehavior())
+	{
+		TSharedPtr<FGridFlowField> Field = MakeShared<FGridFlowField>(*this, GoalIndex, Preferences, bStopAtNeighborLocation, HeuristicFunction);
+		Field->bStale = true;
+		return Field;
+	}
+
+	for (const TSharedPtr<FGridFlowField>& Field : FlowFields)
+	{
+		if (Field->Matches(GoalIndex, Preferences, bStopAtNeighborLocation, HeuristicFunction))
+		{
+			Field->LastUse = ++FlowFieldUseCount;
+			return Field;
+		}
+	}
+
+	TrimFlowFields(FlowFieldCacheSize - 1);
+
+	TSharedPtr<FGridFlowField> Field = MakeShared<FGridFlowField>(*this, GoalIndex, Preferences, bStopAtNeighborLocation, HeuristicFunction);
+	Field->LastUse = ++FlowFieldUseCount;
+	FlowFields.Add(Field);
+	return Field;
+}
+
+FSearchResult ADsGrid::FlowFieldSearch(int32 StartIndex, int32 GoalIndex, FAStarPreferences Preferences, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlowFieldSearch);
+
+	if (!IsValidIndex(StartIndex))
+		return FSearchResult();
+
+	const TSharedPtr<const FGridFlowField> Field = FindOrBuildFlowField(GoalIndex, Preferences, bStopAtNeighborLocation, HeuristicFunction);
+	if (!Field.IsValid())
+		return FSearchResult();
+
+	return Field->TracePath(*this, StartIndex);
+}
+
+void ADsGrid::SetFlowFieldCacheSize(int32 NumFields)
+{
+	FlowFieldCacheSize = FMath::Max(NumFields, 1);
+	TrimFlowFields(FlowFieldCacheSize);
+}
+
+void ADsGrid::TrimFlowFields(int32 MaxFields)
+{
+	while (FlowFields.Num() > MaxFields)
+	{
+		int32 Oldest = 0;
+		for (int32 Entry = 1; Entry < FlowFields.Num(); Entry++)
+		{
+			if (FlowFields[Entry]->LastUse < FlowFields[Oldest]->LastUse)
+				Oldest = Entry;
+		}
+		FlowFields[Oldest]->bStale = true;
+		FlowFields.RemoveAtSwap(Oldest);
+	}
+}
+
+void ADsGrid::InvalidateFlowFields()
+{
+	for (const TSharedPtr<FGridFlowField>& Field : FlowFields)
+		Field->bStale = true;
+	FlowFields.Empty();
+}
+
+void ADsGrid::InvalidateFlowFieldsAt(int32 Index)
+{
+	for (int32 Entry = FlowFields.Num() - 1; Entry >= 0; Entry--)
+	{
+		if (FlowFields[Entry]->DependsOnTile(Index))
+		{
+			FlowFields[Entry]->bStale = true;
+			FlowFields.RemoveAtSwap(Entry);
+		}
+	}
+}
+
+int64 ADsGrid::GetFlowFieldsAllocatedSize() const
+{
+	int64 Size = 0;
+	for (const TSharedPtr<FGridFlowField>& Field : FlowFields)
+		Size += Field->GetAllocatedSize();
+	return Size;
+}
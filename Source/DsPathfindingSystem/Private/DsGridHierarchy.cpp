@@ -0,0 +1,542 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#include "DsGridHierarchy.h"
+#include "DsGridSearch.h"
+#include "Algo/Reverse.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Grid~HPA"), STAT_HierarchicalSearch, STATGROUP_GRID);
+DECLARE_CYCLE_STAT(TEXT("Grid~HPARefine"), STAT_HierarchicalRefine, STATGROUP_GRID);
+DECLARE_CYCLE_STAT(TEXT("Grid~HPABuild"), STAT_HierarchyBuild, STATGROUP_GRID);
+
+namespace
+{
+	FORCEINLINE bool AreNeighbors(const FGridAdjacency& Adjacency, int32 First, int32 Second)
+	{
+		for (int32 Edge = Adjacency.Begin(First); Edge < Adjacency.End(First); Edge++)
+		{
+			if (Adjacency.GetNeighbor(First, Edge) == Second)
+				return true;
+		}
+		return false;
+	}
+}
+
+void FGridHierarchy::Build(const ADsGrid& Grid, int32 InClusterSize, EGridHeuristicFunction InHeuristicFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HierarchyBuild);
+
+	ClusterSize = FMath::Max(InClusterSize, 2);
+	HeuristicFunction = InHeuristicFunction;
+	GridX = Grid.GetGridX();
+	GridY = Grid.GetGridY();
+	bRowMajor = Grid.GetTileOrder() != EGridTileOrder::ColumnMajor;
+	NumClustersX = FMath::DivideAndRoundUp(GridX, ClusterSize);
+	NumClustersY = FMath::DivideAndRoundUp(GridY, ClusterSize);
+
+	Clusters.Reset();
+	Clusters.SetNum(NumClustersX * NumClustersY);
+	DirtyClusters.Reset();
+
+	TArray<int32> All;
+	All.Reserve(Clusters.Num());
+	for (int32 Cluster = 0; Cluster < Clusters.Num(); Cluster++)
+		All.Add(Cluster);
+
+	RebuildClusters(Grid, All);
+}
+
+void FGridHierarchy::Update(const ADsGrid& Grid)
+{
+	if (DirtyClusters.Num() == 0)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_HierarchyBuild);
+
+	TSet<int32> Affected;
+	for (const int32 Cluster : DirtyClusters)
+	{
+		const int32 ClusterColumn = Cluster % NumClustersX;
+		const int32 ClusterRow = Cluster / NumClustersX;
+		for (int32 Row = FMath::Max(ClusterRow - 1, 0); Row <= FMath::Min(ClusterRow + 1, NumClustersY - 1); Row++)
+		{
+			for (int32 Column = FMath::Max(ClusterColumn - 1, 0); Column <= FMath::Min(ClusterColumn + 1, NumClustersX - 1); Column++)
+				Affected.Add(Column + Row * NumClustersX);
+		}
+	}
+	DirtyClusters.Reset();
+
+	RebuildClusters(Grid, Affected.Array());
+}
+
+bool FGridHierarchy::AreTilesNear(int32 First, int32 Second) const
+{
+	const int32 FirstCluster = GetCluster(First);
+	const int32 SecondCluster = GetCluster(Second);
+	return FMath::Abs(FirstCluster % NumClustersX - SecondCluster % NumClustersX) <= 1
+		&& FMath::Abs(FirstCluster / NumClustersX - SecondCluster / NumClustersX) <= 1;
+}
+
+float FGridHierarchy::GetStepCost(const ADsGrid& Grid, int32 From, int32 To) const
+{
+	const FGridTileData& TileData = Grid.GetTileData();
+	return Grid.GetStepDistance(HeuristicFunction, Grid.GetTileLocation(From), Grid.GetTileLocation(To)) + TileData.Cost[To] * TileData.CostScale[To];
+}
+
+bool FGridHierarchy::SearchCluster(const ADsGrid& Grid, FGridSearchScratch& Scratch, int32 Source, bool bReverse, int32 Target) const
+{
+	const FGridTileData& TileData = Grid.GetTileData();
+	const FGridAdjacency& Adjacency = Grid.GetAdjacency(true);
+	const int32 Cluster = GetCluster(Source);
+
+	Scratch.Visit(Source);
+	Scratch.PushOpen(Source);
+
+	while (Scratch.HasOpen())
+	{
+		const int32 CurrentIndex = Scratch.PopOpen();
+		FGridSearchNode& CurrentNode = Scratch.Visit(CurrentIndex);
+		CurrentNode.bClosed = true;
+
+		if (CurrentIndex == Target)
+			return true;
+
+		for (int32 Edge = Adjacency.Begin(CurrentIndex); Edge < Adjacency.End(CurrentIndex); Edge++)
+		{
+			const int32 NeighborIndex = Adjacency.GetNeighbor(CurrentIndex, Edge);
+			if (!TileData.Access[NeighborIndex] || GetCluster(NeighborIndex) != Cluster)
+				continue;
+
+			FGridSearchNode& NextNode = Scratch.Visit(NeighborIndex);
+			if (NextNode.bClosed)
+				continue;
+
+			const float TraversalCost = CurrentNode.TraversalCost + (bReverse ? GetStepCost(Grid, NeighborIndex, CurrentIndex) : GetStepCost(Grid, CurrentIndex, NeighborIndex));
+			const bool bIsOpen = Scratch.IsOpen(NeighborIndex);
+			if (bIsOpen && TraversalCost >= NextNode.TraversalCost)
+				continue;
+
+			NextNode.Parent = CurrentIndex;
+			NextNode.TraversalCost = TraversalCost;
+			NextNode.TotalCost = TraversalCost;
+
+			if (bIsOpen)
+				Scratch.DecreaseKey(NeighborIndex);
+			else
+				Scratch.PushOpen(NeighborIndex);
+		}
+	}
+
+	return Target == INDEX_NONE;
+}
+
+void FGridHierarchy::AddTransition(int32 Cluster, int32 Entrance, int32 Target)
+{
+	FGridCluster& ClusterData = Clusters[Cluster];
+
+	int32 Slot = ClusterData.Entrances.Find(Entrance);
+	if (Slot == INDEX_NONE)
+	{
+		Slot = ClusterData.Entrances.Add(Entrance);
+		ClusterData.Transitions.AddDefaulted();
+	}
+	ClusterData.Transitions[Slot].AddUnique(Target);
+}
+
+void FGridHierarchy::AddBorderTransitions(const ADsGrid& Grid, int32 FirstCluster, int32 SecondCluster, bool bAddToFirst, bool bAddToSecond)
+{
+	const FGridTileData& TileData = Grid.GetTileData();
+	const FGridAdjacency& Adjacency = Grid.GetAdjacency(true);
+
+	const int32 FirstColumn = (FirstCluster % NumClustersX) * ClusterSize;
+	const int32 FirstRow = (FirstCluster / NumClustersX) * ClusterSize;
+	const int32 LastColumn = FMath::Min(FirstColumn + ClusterSize, GridX) - 1;
+	const int32 LastRow = FMath::Min(FirstRow + ClusterSize, GridY) - 1;
+
+	// Walkable edges from the first cluster's outer ring into the second cluster.
+	TArray<FIntPoint> Pairs;
+	for (int32 Row = FirstRow; Row <= LastRow; Row++)
+	{
+		const bool bEdgeRow = Row == FirstRow || Row == LastRow;
+		for (int32 Column = FirstColumn; Column <= LastColumn; Column += (bEdgeRow ? 1 : FMath::Max(LastColumn - FirstColumn, 1)))
+		{
+			const int32 Index = Grid.GetTileIndexAt(Column, Row);
+			if (!TileData.Access[Index])
+				continue;
+
+			for (int32 Edge = Adjacency.Begin(Index); Edge < Adjacency.End(Index); Edge++)
+			{
+				const int32 NeighborIndex = Adjacency.GetNeighbor(Index, Edge);
+				if (TileData.Access[NeighborIndex] && GetCluster(NeighborIndex) == SecondCluster)
+					Pairs.Emplace(Index, NeighborIndex);
+			}
+		}
+	}
+
+	// Ordered by tile index the pairs follow the border, a run breaks where the tiles stop touching.
+	Pairs.Sort([](const FIntPoint& A, const FIntPoint& B)
+		{
+			return A.X != B.X ? A.X < B.X : A.Y < B.Y;
+		});
+
+	int32 RunStart = 0;
+	for (int32 Pair = 1; Pair <= Pairs.Num(); Pair++)
+	{
+		const bool bRunEnds = Pair == Pairs.Num()
+			|| (Pairs[Pair].X != Pairs[Pair - 1].X && !AreNeighbors(Adjacency, Pairs[Pair].X, Pairs[Pair - 1].X))
+			|| (Pairs[Pair].Y != Pairs[Pair - 1].Y && !AreNeighbors(Adjacency, Pairs[Pair].Y, Pairs[Pair - 1].Y));
+
+		if (!bRunEnds)
+			continue;
+
+		const FIntPoint& Transition = Pairs[(RunStart + Pair - 1) / 2];
+		if (bAddToFirst)
+			AddTransition(FirstCluster, Transition.X, Transition.Y);
+		if (bAddToSecond)
+			AddTransition(SecondCluster, Transition.Y, Transition.X);
+
+		RunStart = Pair;
+	}
+}
+
+void FGridHierarchy::RebuildClusters(const ADsGrid& Grid, const TArray<int32>& Rebuilt)
+{
+	TBitArray<> IsRebuilt(false, Clusters.Num());
+	for (const int32 Cluster : Rebuilt)
+	{
+		IsRebuilt[Cluster] = true;
+		Clusters[Cluster].Entrances.Reset();
+		Clusters[Cluster].Transitions.Reset();
+	}
+
+	// Borders are always scanned from the lower cluster, so both sides agree on the transitions
+	// even when only one of them is rebuilt.
+	for (const int32 Cluster : Rebuilt)
+	{
+		const int32 ClusterColumn = Cluster % NumClustersX;
+		const int32 ClusterRow = Cluster / NumClustersX;
+		for (int32 Row = FMath::Max(ClusterRow - 1, 0); Row <= FMath::Min(ClusterRow + 1, NumClustersY - 1); Row++)
+		{
+			for (int32 Column = FMath::Max(ClusterColumn - 1, 0); Column <= FMath::Min(ClusterColumn + 1, NumClustersX - 1); Column++)
+			{
+				const int32 Neighbor = Column + Row * NumClustersX;
+				if (Neighbor == Cluster || (IsRebuilt[Neighbor] && Neighbor < Cluster))
+					continue;
+
+				if (IsRebuilt[Neighbor])
+					AddBorderTransitions(Grid, Cluster, Neighbor, true, true);
+				else if (Cluster < Neighbor)
+					AddBorderTransitions(Grid, Cluster, Neighbor, true, false);
+				else
+					AddBorderTransitions(Grid, Neighbor, Cluster, false, true);
+			}
+		}
+	}
+
+	// Intra cluster costs, one Dijkstra per entrance on the worker's own scratch.
+	const int32 NumTiles = GridX * GridY;
+	ParallelFor(Rebuilt.Num(), [&](int32 RebuiltIndex)
+		{
+			FGridCluster& ClusterData = Clusters[Rebuilt[RebuiltIndex]];
+			const int32 NumEntrances = ClusterData.Entrances.Num();
+			ClusterData.Costs.Init(MAX_flt, NumEntrances * NumEntrances);
+
+			for (int32 From = 0; From < NumEntrances; From++)
+			{
+				FScopedGridSearchScratch Scratch(NumTiles);
+				SearchCluster(Grid, *Scratch, ClusterData.Entrances[From], false);
+
+				for (int32 To = 0; To < NumEntrances; To++)
+				{
+					if (const FGridSearchNode* Node = Scratch->Find(ClusterData.Entrances[To]))
+						ClusterData.Costs[From * NumEntrances + To] = Node->TraversalCost;
+				}
+			}
+		}, EParallelForFlags::Unbalanced);
+}
+
+bool FGridHierarchy::FindAbstractPath(const ADsGrid& Grid, int32 Start, int32 End, TArray<int32>& OutWaypoints) const
+{
+	const int32 StartCluster = GetCluster(Start);
+	const int32 EndCluster = GetCluster(End);
+	const FGridCluster& StartClusterData = Clusters[StartCluster];
+	const FGridCluster& EndClusterData = Clusters[EndCluster];
+	const int32 NumTiles = GridX * GridY;
+
+	// Start and end are linked to the entrances of their own clusters for this query only.
+	TArray<float> StartCosts;
+	StartCosts.Init(MAX_flt, StartClusterData.Entrances.Num());
+	{
+		FScopedGridSearchScratch Scratch(NumTiles);
+		SearchCluster(Grid, *Scratch, Start, false);
+		for (int32 Slot = 0; Slot < StartCosts.Num(); Slot++)
+		{
+			if (const FGridSearchNode* Node = Scratch->Find(StartClusterData.Entrances[Slot]))
+				StartCosts[Slot] = Node->TraversalCost;
+		}
+	}
+
+	TArray<float> EndCosts;
+	EndCosts.Init(MAX_flt, EndClusterData.Entrances.Num());
+	{
+		FScopedGridSearchScratch Scratch(NumTiles);
+		SearchCluster(Grid, *Scratch, End, true);
+		for (int32 Slot = 0; Slot < EndCosts.Num(); Slot++)
+		{
+			if (const FGridSearchNode* Node = Scratch->Find(EndClusterData.Entrances[Slot]))
+				EndCosts[Slot] = Node->TraversalCost;
+		}
+	}
+
+	const FVector EndLocation = Grid.GetTileLocation(End);
+	// The cluster graph is only searched for attribute costs, see ADsGrid::HierarchicalSearch
+	const float HeuristicScale = Grid.GetHeuristicScale(HeuristicFunction, FAStarPreferences());
+
+	FScopedGridSearchScratch AbstractGraph(NumTiles);
+	AbstractGraph->Visit(Start);
+	AbstractGraph->PushOpen(Start);
+
+	while (AbstractGraph->HasOpen())
+	{
+		const int32 CurrentIndex = AbstractGraph->PopOpen();
+		FGridSearchNode& CurrentNode = AbstractGraph->Visit(CurrentIndex);
+		CurrentNode.bClosed = true;
+
+		if (CurrentIndex == End)
+		{
+			OutWaypoints.Reset();
+			for (int32 Waypoint = End; Waypoint != Start; Waypoint = AbstractGraph->Find(Waypoint)->Parent)
+				OutWaypoints.Add(Waypoint);
+			OutWaypoints.Add(Start);
+			Algo::Reverse(OutWaypoints);
+			return true;
+		}
+
+		auto Relax = [&](int32 NextIndex, float TraversalCost)
+			{
+				FGridSearchNode& NextNode = AbstractGraph->Visit(NextIndex);
+				if (NextNode.bClosed)
+					return;
+
+				const bool bIsOpen = AbstractGraph->IsOpen(NextIndex);
+				if (bIsOpen && TraversalCost >= NextNode.TraversalCost)
+					return;
+
+				NextNode.Parent = CurrentIndex;
+				NextNode.TraversalCost = TraversalCost;
+				NextNode.HeuristicCost = Grid.GetHeuristic(HeuristicFunction, Grid.GetTileLocation(NextIndex), EndLocation, HeuristicScale);
+				NextNode.TotalCost = NextNode.TraversalCost + NextNode.HeuristicCost;
+
+				if (bIsOpen)
+					AbstractGraph->DecreaseKey(NextIndex);
+				else
+					AbstractGraph->PushOpen(NextIndex);
+			};
+
+		if (CurrentIndex == Start)
+		{
+			for (int32 Slot = 0; Slot < StartCosts.Num(); Slot++)
+			{
+				if (StartCosts[Slot] < MAX_flt)
+					Relax(StartClusterData.Entrances[Slot], StartCosts[Slot]);
+			}
+		}
+
+		const int32 Cluster = GetCluster(CurrentIndex);
+		const FGridCluster& ClusterData = Clusters[Cluster];
+		const int32 Slot = ClusterData.Entrances.Find(CurrentIndex);
+		if (Slot == INDEX_NONE)
+			continue;
+
+		const int32 NumEntrances = ClusterData.Entrances.Num();
+		for (int32 To = 0; To < NumEntrances; To++)
+		{
+			const float Cost = ClusterData.Costs[Slot * NumEntrances + To];
+			if (To != Slot && Cost < MAX_flt)
+				Relax(ClusterData.Entrances[To], CurrentNode.TraversalCost + Cost);
+		}
+
+		for (const int32 Transition : ClusterData.Transitions[Slot])
+			Relax(Transition, CurrentNode.TraversalCost + GetStepCost(Grid, CurrentIndex, Transition));
+
+		if (Cluster == EndCluster && EndCosts[Slot] < MAX_flt)
+			Relax(End, CurrentNode.TraversalCost + EndCosts[Slot]);
+	}
+
+	return false;
+}
+
+bool FGridHierarchy::RefineSegment(const ADsGrid& Grid, int32 From, int32 To, FSearchResult& Result) const
+{
+	const FGridTileData& TileData = Grid.GetTileData();
+
+	auto Append = [&](int32 Index, int32 Parent)
+		{
+			const float NodeCost = TileData.Cost[Index];
+			Result.PathIndexes.Add(Index);
+			Result.PathResults.Add(Grid.GetTileLocation(Index));
+			Result.PathCosts.Add(Index, NodeCost);
+			Result.Parents.Add(Index, Parent);
+			Result.TotalNodeCost += NodeCost;
+			Result.PathLength++;
+		};
+
+	// Transitions are a single step into the next cluster.
+	if (GetCluster(From) != GetCluster(To))
+	{
+		if (!TileData.Access[To] || !AreNeighbors(Grid.GetAdjacency(true), From, To))
+			return false;
+
+		Append(To, From);
+		return true;
+	}
+
+	FScopedGridSearchScratch Scratch(GridX * GridY);
+	if (!SearchCluster(Grid, *Scratch, From, false, To))
+		return false;
+
+	TArray<int32, TInlineAllocator<64>> Segment;
+	for (int32 Index = To; Index != From; Index = Scratch->Find(Index)->Parent)
+		Segment.Add(Index);
+
+	int32 Parent = From;
+	for (int32 Step = Segment.Num() - 1; Step >= 0; Step--)
+	{
+		Append(Segment[Step], Parent);
+		Parent = Segment[Step];
+	}
+	return true;
+}
+
+SIZE_T FGridHierarchy::GetAllocatedSize() const
+{
+	SIZE_T Size = Clusters.GetAllocatedSize() + DirtyClusters.GetAllocatedSize();
+	for (const FGridCluster& Cluster : Clusters)
+		Size += Cluster.GetAllocatedSize();
+	return Size;
+}
+
+void ADsGrid::SetHierarchyEnabled(bool bEnabled, int32 ClusterSize, EGridHeuristicFunction HeuristicFunction)
+{
+	bHierarchyEnabled = bEnabled;
+	HierarchyClusterSize = ClusterSize;
+	HierarchyHeuristicFunction = HeuristicFunction;
+	BuildHierarchy();
+}
+
+void ADsGrid::UpdateHierarchy()
+{
+	check(IsInGameThread());
+
+	bHierarchyUpdateQueued = false;
+	if (Hierarchy.IsValid())
+		Hierarchy->Update(*this);
+}
+
+void ADsGrid::QueueHierarchyUpdate()
+{
+	if (bHierarchyUpdateQueued)
+		return;
+
+	bHierarchyUpdateQueued = true;
+	TWeakObjectPtr<ADsGrid> WeakGrid(this);
+	AsyncTask(ENamedThreads::GameThread, [WeakGrid]()
+		{
+			if (ADsGrid* Grid = WeakGrid.Get())
+				Grid->UpdateHierarchy();
+		});
+}
+
+int64 ADsGrid::GetHierarchyAllocatedSize() const
+{
+	return Hierarchy.IsValid() ? (int64)Hierarchy->GetAllocatedSize() : 0;
+}
+
+void ADsGrid::BuildHierarchy()
+{
+	if (!bHierarchyEnabled || Tiles.Num() == 0)
+	{
+		Hierarchy.Reset();
+		return;
+	}
+
+	if (!Hierarchy.IsValid())
+		Hierarchy = MakeShared<FGridHierarchy>();
+
+	Hierarchy->Build(*this, HierarchyClusterSize, HierarchyHeuristicFunction);
+}
+
+FHierarchicalPath ADsGrid::HierarchicalSearch(int32 StartIndex, int32 EndIndex, FAStarPreferences Preferences, int32 NumSegmentsToRefine) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_HierarchicalSearch);
+
+	const FGridQueryContext Context = MakeQueryContext(Preferences);
+	const EGridHeuristicFunction HeuristicFunction = Hierarchy.IsValid() ? Hierarchy->GetHeuristicFunction() : HierarchyHeuristicFunction;
+
+	// The cluster graph models the live tile attributes only. Edits and rebuilds happen on the game thread,
+	// so other threads and queries between an edit and its rebuild search without it.
+	const bool bUseHierarchy = IsInGameThread()
+		&& Hierarchy.IsValid()
+		&& Hierarchy->IsBuilt(Tiles.Num())
+		&& !Hierarchy->HasDirtyClusters()
+		&& &GetTileData() == &Tiles
+		&& !HasCustomNodeBehavior()
+		&& !Context.HasTileFilters()
+		&& Preferences.bBlockBorder
+		&& !Preferences.bOverrideNodeCostToOne
+		&& Preferences.TotalNodeCostLimit < 0
+		&& !Preferences.bRecordObstacleIndexes
+		&& IsValidIndex(StartIndex)
+		&& IsValidIndex(EndIndex)
+		&& !Hierarchy->AreTilesNear(StartIndex, EndIndex);
+
+	FHierarchicalPath Path;
+
+	if (!bUseHierarchy)
+	{
+		Path.Waypoints = { StartIndex, EndIndex };
+		Path.Result = AStarSearchWithContext(StartIndex, EndIndex, Context, false, HeuristicFunction);
+		Path.NumRefinedSegments = 1;
+		return Path;
+	}
+
+	Path.Result.EndPoint = EndIndex;
+
+	if (!Tiles.Access[EndIndex] || !Hierarchy->FindAbstractPath(*this, StartIndex, EndIndex, Path.Waypoints))
+	{
+		Path.Result.ResultState = ESearchResult::SearchFail;
+		return Path;
+	}
+
+	Path.Result.ResultState = ESearchResult::SearchSuccess;
+	RefineHierarchicalPath(Path, NumSegmentsToRefine);
+	return Path;
+}
+
+bool ADsGrid::RefineHierarchicalPath(FHierarchicalPath& Path, int32 NumSegments) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_HierarchicalRefine);
+
+	const int32 NumSegmentsLeft = FMath::Max(Path.Waypoints.Num() - 1 - Path.NumRefinedSegments, 0);
+	const int32 NumToRefine = NumSegments < 0 ? NumSegmentsLeft : FMath::Min(NumSegments, NumSegmentsLeft);
+
+	for (int32 Segment = 0; Segment < NumToRefine; Segment++)
+	{
+		const int32 From = Path.Waypoints[Path.NumRefinedSegments];
+		const int32 To = Path.Waypoints[Path.NumRefinedSegments + 1];
+
+		if (!Hierarchy.IsValid() || !Hierarchy->IsBuilt(Tiles.Num()) || !Hierarchy->RefineSegment(*this, From, To, Path.Result))
+		{
+			Path.Result.ResultState = ESearchResult::SearchFail;
+			return false;
+		}
+		Path.NumRefinedSegments++;
+	}
+	return true;
+}
@@ -0,0 +1,115 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DsGrid.h"
+
+class FGridSearchScratch;
+
+/*
+* Entrance graph of one cluster.
+*/
+struct FGridCluster
+{
+	/* Tiles of this cluster that step into a neighboring cluster */
+	TArray<int32> Entrances;
+	/* Cheapest path cost inside the cluster from entrance i to entrance j at [i * Entrances.Num() + j], MAX_flt if unreachable */
+	TArray<float> Costs;
+	/* Per entrance, the tiles of neighboring clusters it steps to */
+	TArray<TArray<int32>> Transitions;
+
+	SIZE_T GetAllocatedSize() const
+	{
+		SIZE_T Size = Entrances.GetAllocatedSize() + Costs.GetAllocatedSize() + Transitions.GetAllocatedSize();
+		for (const TArray<int32>& EntranceTransitions : Transitions)
+			Size += EntranceTransitions.GetAllocatedSize();
+		return Size;
+	}
+};
+
+/*
+* HPA* abstraction of a grid, see ADsGrid::SetHierarchyEnabled.
+* The grid is split into ClusterSize x ClusterSize blocks of columns and rows. Every contiguous run of
+* walkable tile pairs along the border of two clusters gets one transition at its middle.
+* Edges come from the blocked border adjacency table, so square (4 or 8 connected) and hex grids work the same way.
+* Costs follow AStarSearch: distance between tile centers plus the cost of the entered tile.
+*/
+class FGridHierarchy
+{
+public:
+	void Build(const ADsGrid& Grid, int32 InClusterSize, EGridHeuristicFunction InHeuristicFunction);
+
+	FORCEINLINE bool IsBuilt(int32 NumTiles) const
+	{
+		return Clusters.Num() > 0 && GridX * GridY == NumTiles;
+	}
+
+	/* The cluster of the tile is rebuilt by the next Update */
+	FORCEINLINE void MarkTileChanged(int32 Index)
+	{
+		DirtyClusters.Add(GetCluster(Index));
+	}
+
+	FORCEINLINE bool HasDirtyClusters() const
+	{
+		return DirtyClusters.Num() > 0;
+	}
+
+	/* Rebuilds the dirty clusters and their neighbors, whose shared transitions may have moved */
+	void Update(const ADsGrid& Grid);
+
+	FORCEINLINE EGridHeuristicFunction GetHeuristicFunction() const
+	{
+		return HeuristicFunction;
+	}
+
+	/* True if the tiles are in the same or touching clusters, plain A* is cheaper there */
+	bool AreTilesNear(int32 First, int32 Second) const;
+
+	/* A* on the entrance graph. OutWaypoints starts with Start and ends with End. */
+	bool FindAbstractPath(const ADsGrid& Grid, int32 Start, int32 End, TArray<int32>& OutWaypoints) const;
+
+	/* Appends the tiles after From up to To to Result. From and To are consecutive waypoints. */
+	bool RefineSegment(const ADsGrid& Grid, int32 From, int32 To, FSearchResult& Result) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	FORCEINLINE int32 GetCluster(int32 Index) const
+	{
+		const int32 Column = bRowMajor ? Index % GridX : Index / GridY;
+		const int32 Row = bRowMajor ? Index / GridX : Index % GridY;
+		return (Column / ClusterSize) + (Row / ClusterSize) * NumClustersX;
+	}
+
+	float GetStepCost(const ADsGrid& Grid, int32 From, int32 To) const;
+
+	/*
+	* Dijkstra from Source over the walkable tiles of its cluster, costs end up in the scratch nodes.
+	* Reverse follows edges backwards, so costs are from every tile to Source. Stops when Target is closed.
+	*/
+	bool SearchCluster(const ADsGrid& Grid, FGridSearchScratch& Scratch, int32 Source, bool bReverse, int32 Target = INDEX_NONE) const;
+
+	/* Finds the transitions between two clusters and adds them to the clusters selected */
+	void AddBorderTransitions(const ADsGrid& Grid, int32 FirstCluster, int32 SecondCluster, bool bAddToFirst, bool bAddToSecond);
+	void AddTransition(int32 Cluster, int32 Entrance, int32 Target);
+
+	/* Recomputes entrances and intra cluster costs of Rebuilt, the clusters around them keep their side */
+	void RebuildClusters(const ADsGrid& Grid, const TArray<int32>& Rebuilt);
+
+	TArray<FGridCluster> Clusters;
+	TSet<int32> DirtyClusters;
+	int32 ClusterSize = 0;
+	int32 NumClustersX = 0;
+	int32 NumClustersY = 0;
+	int32 GridX = 0;
+	int32 GridY = 0;
+	bool bRowMajor = true;
+	EGridHeuristicFunction HeuristicFunction = EGridHeuristicFunction::Octile;
+};
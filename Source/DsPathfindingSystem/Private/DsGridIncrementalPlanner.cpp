@@ -0,0 +1,421 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#include "DsGridIncrementalPlanner.h"
+#include "DsGridSearch.h"
+
+DECLARE_CYCLE_STAT(TEXT("Grid~IncrementalPlan"), STAT_IncrementalPlan, STATGROUP_GRID);
+
+FGridIncrementalPlanner::FGridIncrementalPlanner(ADsGrid& InGrid, int32 InEndIndex, const FAStarPreferences& Preferences, bool bInStopAtNeighborLocation, EGridHeuristicFunction InHeuristicFunction)
+	: Grid(&InGrid)
+	, Context(InGrid.MakeQueryContext(Preferences))
+	, EndIndex(InEndIndex)
+	, bStopAtNeighborLocation(bInStopAtNeighborLocation)
+	, HeuristicFunction(InHeuristicFunction)
+{
+	TileChangedHandle = InGrid.OnTileChanged.AddRaw(this, &FGridIncrementalPlanner::NotifyTileChanged);
+	LayoutChangedHandle = InGrid.OnLayoutChanged.AddRaw(this, &FGridIncrementalPlanner::OnLayoutChanged);
+}
+
+FGridIncrementalPlanner::~FGridIncrementalPlanner()
+{
+	if (ADsGrid* GridPtr = Grid.Get())
+	{
+		GridPtr->OnTileChanged.Remove(TileChangedHandle);
+		GridPtr->OnLayoutChanged.Remove(LayoutChangedHandle);
+	}
+}
+
+void FGridIncrementalPlanner::NotifyTilesChanged(const TArray<int32>& Indexes)
+{
+	if (bNeedsReset)
+		return;
+
+	for (const int32 Index : Indexes)
+		ChangedTiles.Add(Index);
+}
+
+void FGridIncrementalPlanner::NotifyTileChanged(int32 Index)
+{
+	if (!bNeedsReset)
+		ChangedTiles.Add(Index);
+}
+
+void FGridIncrementalPlanner::OnLayoutChanged()
+{
+	Reset();
+}
+
+void FGridIncrementalPlanner::Reset()
+{
+	bNeedsReset = true;
+	ChangedTiles.Empty();
+}
+
+void FGridIncrementalPlanner::Initialize(int32 InStartIndex)
+{
+	const ADsGrid* GridPtr = Grid.Get();
+	const int32 NumTiles = GridPtr->GetGridSize();
+
+	G.Init(MAX_flt, NumTiles);
+	Rhs.Init(MAX_flt, NumTiles);
+	Keys.SetNumUninitialized(NumTiles);
+	HeapIndex.Init(INDEX_NONE, NumTiles);
+	Heap.Reset();
+	ChangedTiles.Reset();
+
+	StartIndex = InStartIndex;
+	KeyModifier = 0.0f;
+	HeuristicScale = GridPtr->GetHeuristicScale(HeuristicFunction, Context.Preferences);
+	bNeedsReset = false;
+	NumResets++;
+
+	if (bStopAtNeighborLocation)
+		GoalIndexes = GridPtr->GetNeighborTilesAsArray(EndIndex, Context.Preferences.bBlockBorder);
+	else
+		GoalIndexes = { EndIndex };
+
+	for (const int32 Goal : GoalIndexes)
+	{
+		Rhs[Goal] = 0.0f;
+		HeapPush(Goal, CalculateKey(Goal));
+	}
+}
+
+FSearchResult FGridIncrementalPlanner::Plan(int32 InStartIndex)
+{
+	SCOPE_CYCLE_COUNTER(STAT_IncrementalPlan);
+
+	const ADsGrid* GridPtr = Grid.Get();
+	if (!GridPtr || !GridPtr->IsValidIndex(InStartIndex) || !GridPtr->IsValidIndex(EndIndex))
+		return FSearchResult();
+
+	return DispatchGridCostPolicy(*GridPtr, Context, [&](auto Policy)
+		{
+			return PlanImpl(InStartIndex, Policy);
+		});
+}
+
+template<typename PolicyType>
+FSearchResult FGridIncrementalPlanner::PlanImpl(int32 InStartIndex, const PolicyType& Policy)
+{
+	const ADsGrid* GridPtr = Grid.Get();
+
+	FSearchResult Result;
+	Result.EndPoint = EndIndex;
+	Result.bStopAtNeighborLocation = bStopAtNeighborLocation;
+
+	if (InStartIndex == EndIndex || (bStopAtNeighborLocation && GridPtr->GetNeighborTilesAsArray(EndIndex, Context.Preferences.bBlockBorder).Contains(InStartIndex)))
+	{
+		Result.ResultState = ESearchResult::AlreadyAtGoal;
+		return Result;
+	}
+
+	if (!bStopAtNeighborLocation && !Policy.GetAccess(-1, EndIndex, EndIndex).bAccess)
+		return Result;
+
+	// Queued keys were computed with the old scale, a lower one could make them overestimate
+	if (bNeedsReset || G.Num() != GridPtr->GetGridSize() || GridPtr->GetHeuristicScale(HeuristicFunction, Context.Preferences) < HeuristicScale)
+	{
+		Initialize(InStartIndex);
+	}
+	else
+	{
+		if (InStartIndex != StartIndex)
+		{
+			KeyModifier += GridPtr->GetHeuristic(HeuristicFunction, GridPtr->GetTileLocation(StartIndex), GridPtr->GetTileLocation(InStartIndex), HeuristicScale);
+			StartIndex = InStartIndex;
+		}
+
+		// A changed tile changes the cost of every edge entering it
+		const FGridAdjacency& Predecessors = GridPtr->GetPredecessors(Context.Preferences.bBlockBorder);
+		for (const int32 Index : ChangedTiles)
+		{
+			if (!GridPtr->IsValidIndex(Index))
+				continue;
+
+			UpdateVertex(Policy, Index);
+			for (int32 Edge = Predecessors.Begin(Index); Edge < Predecessors.End(Index); Edge++)
+				UpdateVertex(Policy, Predecessors.GetNeighbor(Index, Edge));
+		}
+		ChangedTiles.Reset();
+	}
+
+	const int32 Expansions = ComputeShortestPath(Policy);
+	NumExpansions += Expansions;
+
+	Result = ExtractPath(Policy);
+	Result.NumBackwardExpansions = Expansions;
+	return Result;
+}
+
+template<typename PolicyType>
+float FGridIncrementalPlanner::GetEdgeCost(const PolicyType& Policy, int32 From, int32 To, ENeighborDirection Direction, float* OutNodeCost) const
+{
+	const ADsGrid* GridPtr = Grid.Get();
+	const FGridStepAccess Access = Policy.GetAccess(From, To, EndIndex, Direction);
+	if (!Access.bAccess)
+		return MAX_flt;
+
+	if (OutNodeCost)
+		*OutNodeCost = Context.Preferences.bOverrideNodeCostToOne ? 1.0f : Access.NodeCost;
+
+	return GridPtr->GetStepDistance(HeuristicFunction, GridPtr->GetTileLocation(From), GridPtr->GetTileLocation(To))
+		+ (Context.Preferences.bOverrideNodeCostToOne ? 1.0f : Access.NodeCost * Access.NodeCostScale);
+}
+
+template<typename PolicyType>
+float FGridIncrementalPlanner::ComputeRhs(const PolicyType& Policy, int32 Index) const
+{
+	const FGridAdjacency& Adjacency = Grid->GetAdjacency(Context.Preferences.bBlockBorder);
+
+	float Best = MAX_flt;
+	for (int32 Edge = Adjacency.Begin(Index); Edge < Adjacency.End(Index); Edge++)
+	{
+		const int32 NeighborIndex = Adjacency.GetNeighbor(Index, Edge);
+		if (G[NeighborIndex] == MAX_flt)
+			continue;
+
+		const float EdgeCost = GetEdgeCost(Policy, Index, NeighborIndex, Adjacency.Directions[Edge]);
+		if (EdgeCost != MAX_flt)
+			Best = FMath::Min(Best, EdgeCost + G[NeighborIndex]);
+	}
+	return Best;
+}
+
+FGridIncrementalPlanner::FKey FGridIncrementalPlanner::CalculateKey(int32 Index) const
+{
+	const ADsGrid* GridPtr = Grid.Get();
+	const float Cost = FMath::Min(G[Index], Rhs[Index]);
+
+	FKey Key;
+	Key.Primary = Cost == MAX_flt ? MAX_flt : Cost + KeyModifier + GridPtr->GetHeuristic(HeuristicFunction, GridPtr->GetTileLocation(StartIndex), GridPtr->GetTileLocation(Index), HeuristicScale);
+	Key.Secondary = Cost;
+	return Key;
+}
+
+template<typename PolicyType>
+void FGridIncrementalPlanner::UpdateVertex(const PolicyType& Policy, int32 Index)
+{
+	if (!IsGoal(Index))
+		Rhs[Index] = ComputeRhs(Policy, Index);
+	UpdateQueue(Index);
+}
+
+void FGridIncrementalPlanner::UpdateQueue(int32 Index)
+{
+	const bool bQueued = HeapIndex[Index] != INDEX_NONE;
+	if (G[Index] != Rhs[Index])
+	{
+		if (bQueued)
+			HeapUpdate(Index, CalculateKey(Index));
+		else
+			HeapPush(Index, CalculateKey(Index));
+	}
+	else if (bQueued)
+	{
+		HeapRemove(Index);
+	}
+}
+
+template<typename PolicyType>
+int32 FGridIncrementalPlanner::ComputeShortestPath(const PolicyType& Policy)
+{
+	const FGridAdjacency& Predecessors = Grid->GetPredecessors(Context.Preferences.bBlockBorder);
+
+	int32 Expansions = 0;
+	while (Heap.Num() > 0)
+	{
+		// Keys that tie with the start key can differ in the last bits (KeyModifier sums), the tolerance only costs a few extra expansions
+		const FKey StartKey = CalculateKey(StartIndex);
+		if (TopKey().Primary > StartKey.Primary + StartKey.Primary * 1e-4f + KINDA_SMALL_NUMBER && Rhs[StartIndex] == G[StartIndex])
+			break;
+
+		const int32 Index = Heap[0];
+		const FKey OldKey = TopKey();
+		const FKey NewKey = CalculateKey(Index);
+		Expansions++;
+
+		// The key was computed for an earlier start
+		if (OldKey < NewKey)
+		{
+			HeapUpdate(Index, NewKey);
+			continue;
+		}
+
+		if (G[Index] > Rhs[Index])
+		{
+			// Cheaper than before: relax the edges entering the tile
+			G[Index] = Rhs[Index];
+			HeapRemove(Index);
+
+			for (int32 Edge = Predecessors.Begin(Index); Edge < Predecessors.End(Index); Edge++)
+			{
+				const int32 PredecessorIndex = Predecessors.GetNeighbor(Index, Edge);
+				if (IsGoal(PredecessorIndex))
+					continue;
+
+				const float EdgeCost = GetEdgeCost(Policy, PredecessorIndex, Index, Predecessors.Directions[Edge]);
+				if (EdgeCost != MAX_flt && EdgeCost + G[Index] < Rhs[PredecessorIndex])
+				{
+					Rhs[PredecessorIndex] = EdgeCost + G[Index];
+					UpdateQueue(PredecessorIndex);
+				}
+			}
+		}
+		else
+		{
+			// More expensive than before: only tiles that went through this one need a new lookahead
+			const float OldG = G[Index];
+			G[Index] = MAX_flt;
+			UpdateVertex(Policy, Index);
+
+			for (int32 Edge = Predecessors.Begin(Index); Edge < Predecessors.End(Index); Edge++)
+			{
+				const int32 PredecessorIndex = Predecessors.GetNeighbor(Index, Edge);
+				if (IsGoal(PredecessorIndex) || Rhs[PredecessorIndex] == MAX_flt)
+					continue;
+
+				const float EdgeCost = GetEdgeCost(Policy, PredecessorIndex, Index, Predecessors.Directions[Edge]);
+				if (EdgeCost != MAX_flt && Rhs[PredecessorIndex] >= EdgeCost + OldG)
+					UpdateVertex(Policy, PredecessorIndex);
+			}
+		}
+	}
+
+	return Expansions;
+}
+
+template<typename PolicyType>
+FSearchResult FGridIncrementalPlanner::ExtractPath(const PolicyType& Policy) const
+{
+	const ADsGrid* GridPtr = Grid.Get();
+	const FGridAdjacency& Adjacency = GridPtr->GetAdjacency(Context.Preferences.bBlockBorder);
+
+	FSearchResult Result;
+	Result.EndPoint = EndIndex;
+	Result.bStopAtNeighborLocation = bStopAtNeighborLocation;
+
+	if (G[StartIndex] == MAX_flt)
+		return Result;
+
+	// Greedy descent over g. Zero cost steps can tie, tiles already on the path are not entered twice.
+	TSet<int32> Visited;
+	Visited.Add(StartIndex);
+
+	int32 Current = StartIndex;
+	while (!IsGoal(Current))
+	{
+		int32 BestIndex = INDEX_NONE;
+		float BestCost = MAX_flt;
+		float BestNodeCost = 0.0f;
+		for (int32 Edge = Adjacency.Begin(Current); Edge < Adjacency.End(Current); Edge++)
+		{
+			const int32 NeighborIndex = Adjacency.GetNeighbor(Current, Edge);
+			if (G[NeighborIndex] == MAX_flt || Visited.Contains(NeighborIndex))
+				continue;
+
+			float NodeCost = 0.0f;
+			const float EdgeCost = GetEdgeCost(Policy, Current, NeighborIndex, Adjacency.Directions[Edge], &NodeCost);
+			if (EdgeCost != MAX_flt && EdgeCost + G[NeighborIndex] < BestCost)
+			{
+				BestIndex = NeighborIndex;
+				BestCost = EdgeCost + G[NeighborIndex];
+				BestNodeCost = NodeCost;
+			}
+		}
+
+		if (BestIndex == INDEX_NONE)
+		{
+			Result = FSearchResult();
+			Result.EndPoint = EndIndex;
+			Result.bStopAtNeighborLocation = bStopAtNeighborLocation;
+			return Result;
+		}
+
+		Result.PathResults.Add(GridPtr->GetTileLocation(BestIndex));
+		Result.PathIndexes.Add(BestIndex);
+		Result.PathLength = Result.PathLength + 1;
+		Result.TotalNodeCost += BestNodeCost;
+		Result.PathCosts.Add(BestIndex, BestNodeCost);
+		Result.Parents.Add(BestIndex, Current);
+
+		Visited.Add(BestIndex);
+		Current = BestIndex;
+	}
+	Result.ResultState = ESearchResult::SearchSuccess;
+
+	return Result;
+}
+
+void FGridIncrementalPlanner::HeapPush(int32 Index, const FKey& Key)
+{
+	Keys[Index] = Key;
+	HeapIndex[Index] = Heap.Add(Index);
+	HeapSiftUp(HeapIndex[Index]);
+}
+
+void FGridIncrementalPlanner::HeapRemove(int32 Index)
+{
+	const int32 Position = HeapIndex[Index];
+	HeapIndex[Index] = INDEX_NONE;
+
+	const int32 Last = Heap.Pop(EAllowShrinking::No);
+	if (Position == Heap.Num())
+		return;
+
+	Heap[Position] = Last;
+	HeapIndex[Last] = Position;
+	HeapSiftUp(Position);
+	HeapSiftDown(HeapIndex[Last]);
+}
+
+void FGridIncrementalPlanner::HeapUpdate(int32 Index, const FKey& Key)
+{
+	Keys[Index] = Key;
+	HeapSiftUp(HeapIndex[Index]);
+	HeapSiftDown(HeapIndex[Index]);
+}
+
+void FGridIncrementalPlanner::HeapSiftUp(int32 Position)
+{
+	const int32 Index = Heap[Position];
+	while (Position > 0)
+	{
+		const int32 ParentPosition = (Position - 1) / 2;
+		if (!(Keys[Index] < Keys[Heap[ParentPosition]]))
+			break;
+
+		Heap[Position] = Heap[ParentPosition];
+		HeapIndex[Heap[Position]] = Position;
+		Position = ParentPosition;
+	}
+	Heap[Position] = Index;
+	HeapIndex[Index] = Position;
+}
+
+void FGridIncrementalPlanner::HeapSiftDown(int32 Position)
+{
+	const int32 Index = Heap[Position];
+	const int32 Num = Heap.Num();
+	while (true)
+	{
+		int32 ChildPosition = Position * 2 + 1;
+		if (ChildPosition >= Num)
+			break;
+		if (ChildPosition + 1 < Num && Keys[Heap[ChildPosition + 1]] < Keys[Heap[ChildPosition]])
+			ChildPosition++;
+		if (!(Keys[Heap[ChildPosition]] < Keys[Index]))
+			break;
+
+		Heap[Position] = Heap[ChildPosition];
+		HeapIndex[Heap[Position]] = Position;
+		Position = ChildPosition;
+	}
+	Heap[Position] = Index;
+	HeapIndex[Index] = Position;
+}
@@ -0,0 +1,654 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#include "DsGridJumpPointSearch.h"
+#include "DsGridSearch.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Grid~JPS"), STAT_JumpPointSearch, STATGROUP_GRID);
+DECLARE_CYCLE_STAT(TEXT("Grid~JPSTableBuild"), STAT_JumpPointTableBuild, STATGROUP_GRID);
+DECLARE_CYCLE_STAT(TEXT("Grid~JPSTableUpdate"), STAT_JumpPointTableUpdate, STATGROUP_GRID);
+
+namespace
+{
+	/*
+	* Square grid view used by the jump functions. Tiles outside of the grid are blocked.
+	* Diagonal moves may cut corners, the same as AStarSearch.
+	*/
+	struct FJumpPointGrid
+	{
+		const FGridTileData& TileData;
+		const FGridQueryContext& Context;
+		int32 GridX;
+		int32 GridY;
+		int32 ColumnStride;
+		int32 RowStride;
+		int32 GoalColumn;
+		int32 GoalRow;
+
+		FORCEINLINE int32 ToIndex(int32 Column, int32 Row) const
+		{
+			return Column * ColumnStride + Row * RowStride;
+		}
+
+		FORCEINLINE bool IsWalkable(int32 Column, int32 Row) const
+		{
+			if (Column < 0 || Row < 0 || Column >= GridX || Row >= GridY)
+				return false;
+
+			const int32 Index = ToIndex(Column, Row);
+			return TileData.Access[Index] && !Context.IsTileExcluded(Index, TileData.Type[Index]);
+		}
+
+		FORCEINLINE bool IsGoal(int32 Column, int32 Row) const
+		{
+			return Column == GoalColumn && Row == GoalRow;
+		}
+
+		/* 8 connected, straight. Walks from Column/Row until a jump point is found or the way is blocked. */
+		bool JumpStraight(int32& Column, int32& Row, int32 DColumn, int32 DRow) const
+		{
+			while (true)
+			{
+				Column += DColumn;
+				Row += DRow;
+
+				if (!IsWalkable(Column, Row))
+					return false;
+				if (IsGoal(Column, Row))
+					return true;
+
+				if (DColumn != 0)
+				{
+					if ((IsWalkable(Column + DColumn, Row + 1) && !IsWalkable(Column, Row + 1)) || (IsWalkable(Column + DColumn, Row - 1) && !IsWalkable(Column, Row - 1)))
+						return true;
+				}
+				else
+				{
+					if ((IsWalkable(Column + 1, Row + DRow) && !IsWalkable(Column + 1, Row)) || (IsWalkable(Column - 1, Row + DRow) && !IsWalkable(Column - 1, Row)))
+						return true;
+				}
+			}
+		}
+
+		/* 8 connected, diagonal. Every tile also scans both straight components. */
+		bool JumpDiagonal(int32& Column, int32& Row, int32 DColumn, int32 DRow) const
+		{
+			while (true)
+			{
+				Column += DColumn;
+				Row += DRow;
+
+				if (!IsWalkable(Column, Row))
+					return false;
+				if (IsGoal(Column, Row))
+					return true;
+
+				if ((IsWalkable(Column - DColumn, Row + DRow) && !IsWalkable(Column - DColumn, Row)) || (IsWalkable(Column + DColumn, Row - DRow) && !IsWalkable(Column, Row - DRow)))
+					return true;
+
+				int32 ScanColumn = Column;
+				int32 ScanRow = Row;
+				if (JumpStraight(ScanColumn, ScanRow, DColumn, 0))
+					return true;
+
+				ScanColumn = Column;
+				ScanRow = Row;
+				if (JumpStraight(ScanColumn, ScanRow, 0, DRow))
+					return true;
+			}
+		}
+
+		/* 4 connected. Moves along rows scan both column directions at every tile. */
+		bool JumpCardinal(int32& Column, int32& Row, int32 DColumn, int32 DRow) const
+		{
+			while (true)
+			{
+				Column += DColumn;
+				Row += DRow;
+
+				if (!IsWalkable(Column, Row))
+					return false;
+				if (IsGoal(Column, Row))
+					return true;
+
+				if (DColumn != 0)
+				{
+					if ((IsWalkable(Column, Row - 1) && !IsWalkable(Column - DColumn, Row - 1)) || (IsWalkable(Column, Row + 1) && !IsWalkable(Column - DColumn, Row + 1)))
+						return true;
+				}
+				else
+				{
+					if ((IsWalkable(Column - 1, Row) && !IsWalkable(Column - 1, Row - DRow)) || (IsWalkable(Column + 1, Row) && !IsWalkable(Column + 1, Row - DRow)))
+						return true;
+
+					int32 ScanColumn = Column;
+					int32 ScanRow = Row;
+					if (JumpCardinal(ScanColumn, ScanRow, 1, 0))
+						return true;
+
+					ScanColumn = Column;
+					ScanRow = Row;
+					if (JumpCardinal(ScanColumn, ScanRow, -1, 0))
+						return true;
+				}
+			}
+		}
+	};
+
+	/* Jumps by scanning the tiles */
+	template<bool bInDiagonal>
+	struct TJumpPointScanner : public FJumpPointGrid
+	{
+		static constexpr bool bDiagonal = bInDiagonal;
+
+		FORCEINLINE bool Jump(int32& Column, int32& Row, int32 DColumn, int32 DRow) const
+		{
+			if (!bDiagonal)
+				return JumpCardinal(Column, Row, DColumn, DRow);
+			if (DColumn != 0 && DRow != 0)
+				return JumpDiagonal(Column, Row, DColumn, DRow);
+			return JumpStraight(Column, Row, DColumn, DRow);
+		}
+	};
+
+	/* Jumps with the precomputed JPS+ distances */
+	template<bool bInDiagonal>
+	struct TJumpPointTableReader : public FJumpPointGrid
+	{
+		static constexpr bool bDiagonal = bInDiagonal;
+
+		const FGridJumpPointTable& Table;
+
+		FORCEINLINE bool Jump(int32& Column, int32& Row, int32 DColumn, int32 DRow) const
+		{
+			const int32 Distance = Table.GetDistance(Column, Row, FGridJumpPointTable::GetDirection(DColumn, DRow));
+			const int32 GoalDColumn = GoalColumn - Column;
+			const int32 GoalDRow = GoalRow - Row;
+
+			// Tiles the scanning jump would stop on because of the goal.
+			int32 GoalSteps = 0;
+			if (bDiagonal && DColumn != 0 && DRow != 0)
+			{
+				// Goal row or column, a straight jump from there may reach the goal.
+				if (FMath::Sign(GoalDColumn) == DColumn && FMath::Sign(GoalDRow) == DRow)
+					GoalSteps = FMath::Min(FMath::Abs(GoalDColumn), FMath::Abs(GoalDRow));
+			}
+			else if (!bDiagonal && DRow != 0)
+			{
+				// Goal row, the column scan from there may reach the goal.
+				if (FMath::Sign(GoalDRow) == DRow)
+					GoalSteps = FMath::Abs(GoalDRow);
+			}
+			else if (DRow == 0 ? (GoalDRow == 0 && FMath::Sign(GoalDColumn) == DColumn) : (GoalDColumn == 0 && FMath::Sign(GoalDRow) == DRow))
+			{
+				GoalSteps = FMath::Abs(GoalDColumn) + FMath::Abs(GoalDRow);
+			}
+
+			const int32 Steps = GoalSteps > 0 && GoalSteps <= FMath::Abs(Distance) ? GoalSteps : Distance;
+			if (Steps <= 0)
+				return false;
+
+			Column += Steps * DColumn;
+			Row += Steps * DRow;
+			return true;
+		}
+	};
+
+	/* Move directions of a jump point, pruned by the direction it was reached from */
+	struct FJumpDirections
+	{
+		int32 Column[8];
+		int32 Row[8];
+		int32 Num = 0;
+
+		FORCEINLINE void Add(int32 DColumn, int32 DRow)
+		{
+			Column[Num] = DColumn;
+			Row[Num] = DRow;
+			Num++;
+		}
+	};
+}
+
+FSearchResult ADsGrid::JumpPointSearch(int32 StartIndex, int32 EndIndex, FAStarPreferences Preferences, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction) const
+{
+	return JumpPointSearchWithContext(StartIndex, EndIndex, MakeQueryContext(Preferences), bStopAtNeighborLocation, HeuristicFunction);
+}
+
+FSearchResult ADsGrid::JumpPointSearchWithContext(int32 StartIndex, int32 EndIndex, const FGridQueryContext& Context, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction) const
+{
+	const FAStarPreferences& Preferences = Context.Preferences;
+	const FGridTileData& TileData = GetTileData();
+
+	// Jump points are only valid while every step in a direction costs the same.
+	const bool bUseAStar = GridType != EGridType::Square
+		|| !Preferences.bBlockBorder
+		|| bStopAtNeighborLocation
+		|| Preferences.TotalNodeCostLimit >= 0
+		|| Preferences.bRecordObstacleIndexes
+		|| HasCustomNodeBehavior()
+		|| (!Preferences.bOverrideNodeCostToOne && !TileData.HasUniformCost())
+		|| !IsValidIndex(StartIndex)
+		|| !IsValidIndex(EndIndex)
+		|| StartIndex == EndIndex;
+
+	if (bUseAStar)
+		return AStarSearchWithContext(StartIndex, EndIndex, Context, bStopAtNeighborLocation, HeuristicFunction);
+
+	SCOPE_CYCLE_COUNTER(STAT_JumpPointSearch);
+
+	const bool bRowMajor = TileOrder != EGridTileOrder::ColumnMajor;
+	const FJumpPointGrid Grid{ TileData, Context, GridX, GridY, bRowMajor ? 1 : GridY, bRowMajor ? GridX : 1, GetIndexColumn(EndIndex), GetIndexRow(EndIndex) };
+
+	// The tables only know the live tile access, filtered queries and snapshots scan.
+	const bool bUseTable = JumpPointTable.IsValid() && JumpPointTable->IsBuilt(Tiles.Num()) && &TileData == &Tiles && !Context.HasTileFilters();
+
+	if (bUseTable)
+	{
+		return bSquareGridDiagonalAllowed
+			? JumpPointSearchImpl(StartIndex, EndIndex, Context, HeuristicFunction, TJumpPointTableReader<true>{ Grid, *JumpPointTable })
+			: JumpPointSearchImpl(StartIndex, EndIndex, Context, HeuristicFunction, TJumpPointTableReader<false>{ Grid, *JumpPointTable });
+	}
+
+	return bSquareGridDiagonalAllowed
+		? JumpPointSearchImpl(StartIndex, EndIndex, Context, HeuristicFunction, TJumpPointScanner<true>{ Grid })
+		: JumpPointSearchImpl(StartIndex, EndIndex, Context, HeuristicFunction, TJumpPointScanner<false>{ Grid });
+}
+
+template<typename JumperType>
+FSearchResult ADsGrid::JumpPointSearchImpl(int32 StartIndex, int32 EndIndex, const FGridQueryContext& Context, EGridHeuristicFunction HeuristicFunction, const JumperType& Grid) const
+{
+	constexpr bool bDiagonal = JumperType::bDiagonal;
+	const FAStarPreferences& Preferences = Context.Preferences;
+	const FGridTileData& TileData = GetTileData();
+
+	FSearchResult Result;
+	Result.EndPoint = EndIndex;
+	Result.bStopAtNeighborLocation = false;
+	Result.ResultState = ESearchResult::SearchFail;
+
+	// Jump point searches only run without a custom NodeBehavior, the tile policy is the one the dispatch would pick
+	const FGridTilePolicy Policy(*this, Context);
+	if (!Policy.GetAccess(-1, EndIndex, EndIndex).bAccess)
+		return Result;
+
+	// Step costs as AStarSearch sums them: distance between the tile centers plus the unit node cost.
+	const FVector2D Step = GetTileStep() * TileScale;
+	const float StepCostColumn = GetHeuristic(HeuristicFunction, FVector::ZeroVector, FVector(Step.X, 0.0f, 0.0f)) + 1.0f;
+	const float StepCostRow = GetHeuristic(HeuristicFunction, FVector::ZeroVector, FVector(0.0f, Step.Y, 0.0f)) + 1.0f;
+	const float StepCostDiagonal = GetHeuristic(HeuristicFunction, FVector::ZeroVector, FVector(Step.X, Step.Y, 0.0f)) + 1.0f;
+
+	const FVector EndLocation = GetTileLocation(EndIndex);
+
+	FScopedGridSearchScratch GridGraph(GridX * GridY);
+
+	GridGraph->Visit(StartIndex);
+	GridGraph->PushOpen(StartIndex);
+
+	bool bFound = false;
+
+	while (GridGraph->HasOpen())
+	{
+		const int32 CurrentIndex = GridGraph->PopOpen();
+		if (CurrentIndex == EndIndex)
+		{
+			bFound = true;
+			break;
+		}
+
+		FGridSearchNode& CurrentNode = GridGraph->Visit(CurrentIndex);
+		CurrentNode.bClosed = true;
+
+		const int32 Column = GetIndexColumn(CurrentIndex);
+		const int32 Row = GetIndexRow(CurrentIndex);
+
+		FJumpDirections Directions;
+		if (CurrentNode.Parent == -1)
+		{
+			Directions.Add(1, 0);
+			Directions.Add(-1, 0);
+			Directions.Add(0, 1);
+			Directions.Add(0, -1);
+			if (bDiagonal)
+			{
+				Directions.Add(1, 1);
+				Directions.Add(1, -1);
+				Directions.Add(-1, 1);
+				Directions.Add(-1, -1);
+			}
+		}
+		else
+		{
+			const int32 DColumn = FMath::Sign(Column - GetIndexColumn(CurrentNode.Parent));
+			const int32 DRow = FMath::Sign(Row - GetIndexRow(CurrentNode.Parent));
+
+			if (!bDiagonal)
+			{
+				if (DColumn != 0)
+				{
+					Directions.Add(0, -1);
+					Directions.Add(0, 1);
+					Directions.Add(DColumn, 0);
+				}
+				else
+				{
+					Directions.Add(-1, 0);
+					Directions.Add(1, 0);
+					Directions.Add(0, DRow);
+				}
+			}
+			else if (DColumn != 0 && DRow != 0)
+			{
+				Directions.Add(0, DRow);
+				Directions.Add(DColumn, 0);
+				Directions.Add(DColumn, DRow);
+				if (!Grid.IsWalkable(Column - DColumn, Row))
+					Directions.Add(-DColumn, DRow);
+				if (!Grid.IsWalkable(Column, Row - DRow))
+					Directions.Add(DColumn, -DRow);
+			}
+			else if (DColumn == 0)
+			{
+				Directions.Add(0, DRow);
+				if (!Grid.IsWalkable(Column + 1, Row))
+					Directions.Add(1, DRow);
+				if (!Grid.IsWalkable(Column - 1, Row))
+					Directions.Add(-1, DRow);
+			}
+			else
+			{
+				Directions.Add(DColumn, 0);
+				if (!Grid.IsWalkable(Column, Row + 1))
+					Directions.Add(DColumn, 1);
+				if (!Grid.IsWalkable(Column, Row - 1))
+					Directions.Add(DColumn, -1);
+			}
+		}
+
+		for (int32 Direction = 0; Direction < Directions.Num; Direction++)
+		{
+			const int32 DColumn = Directions.Column[Direction];
+			const int32 DRow = Directions.Row[Direction];
+
+			int32 JumpColumn = Column;
+			int32 JumpRow = Row;
+			if (!Grid.Jump(JumpColumn, JumpRow, DColumn, DRow))
+				continue;
+
+			const int32 JumpIndex = Grid.ToIndex(JumpColumn, JumpRow);
+			FGridSearchNode& JumpNode = GridGraph->Visit(JumpIndex);
+			if (JumpNode.bClosed)
+				continue;
+
+			const int32 NumSteps = FMath::Max(FMath::Abs(JumpColumn - Column), FMath::Abs(JumpRow - Row));
+			const float StepCost = DColumn != 0 && DRow != 0 ? StepCostDiagonal : DColumn != 0 ? StepCostColumn : StepCostRow;
+			const float TraversalCost = CurrentNode.TraversalCost + NumSteps * StepCost;
+
+			const bool bIsOpen = GridGraph->IsOpen(JumpIndex);
+			if (bIsOpen && TraversalCost >= JumpNode.TraversalCost)
+				continue;
+
+			JumpNode.Parent = CurrentIndex;
+			JumpNode.TraversalCost = TraversalCost;
+			JumpNode.HeuristicCost = GetHeuristic(HeuristicFunction, GetTileLocation(JumpIndex), EndLocation);
+			JumpNode.TotalCost = JumpNode.TraversalCost + JumpNode.HeuristicCost;
+
+			if (bIsOpen)
+				GridGraph->DecreaseKey(JumpIndex);
+			else
+				GridGraph->PushOpen(JumpIndex);
+		}
+	}
+
+	if (!bFound)
+		return Result;
+
+	// Expand the jump points back into every tile between them.
+	TArray<int32> JumpPoints;
+	for (int32 Current = EndIndex; Current != -1; Current = GridGraph->Find(Current)->Parent)
+		JumpPoints.Add(Current);
+
+	int32 Previous = StartIndex;
+	for (int32 JumpPoint = JumpPoints.Num() - 2; JumpPoint >= 0; JumpPoint--)
+	{
+		const int32 TargetColumn = GetIndexColumn(JumpPoints[JumpPoint]);
+		const int32 TargetRow = GetIndexRow(JumpPoints[JumpPoint]);
+		int32 Column = GetIndexColumn(Previous);
+		int32 Row = GetIndexRow(Previous);
+		const int32 DColumn = FMath::Sign(TargetColumn - Column);
+		const int32 DRow = FMath::Sign(TargetRow - Row);
+
+		while (Column != TargetColumn || Row != TargetRow)
+		{
+			Column += DColumn;
+			Row += DRow;
+
+			const int32 Index = Grid.ToIndex(Column, Row);
+			const float NodeCost = Preferences.bOverrideNodeCostToOne ? 1.0f : Policy.GetAccess(Previous, Index, EndIndex).NodeCost;
+
+			Result.PathIndexes.Add(Index);
+			Result.PathResults.Add(GetTileLocation(Index));
+			Result.PathCosts.Add(Index, NodeCost);
+			Result.Parents.Add(Index, Previous);
+			Result.TotalNodeCost += NodeCost;
+			Result.PathLength++;
+
+			Previous = Index;
+		}
+	}
+
+	Result.ResultState = ESearchResult::SearchSuccess;
+	return Result;
+}
+
+bool FGridJumpPointTable::Build(const FGridTileData& Tiles, int32 InGridX, int32 InGridY, EGridTileOrder TileOrder, bool bDiagonal)
+{
+	SCOPE_CYCLE_COUNTER(STAT_JumpPointTableBuild);
+
+	Empty();
+
+	if (FMath::Max(InGridX, InGridY) >= MAX_int16 || Tiles.Num() != InGridX * InGridY)
+		return false;
+
+	const bool bRowMajor = TileOrder != EGridTileOrder::ColumnMajor;
+	GridX = InGridX;
+	GridY = InGridY;
+	ColumnStride = bRowMajor ? 1 : GridY;
+	RowStride = bRowMajor ? GridX : 1;
+	NumDirections = bDiagonal ? 8 : 4;
+	FirstDependentDirection = bDiagonal ? 4 : 2;
+
+	Walkable = Tiles.Access;
+	Distances.SetNumUninitialized(Tiles.Num() * NumDirections);
+
+	BuildDirections(0, FirstDependentDirection);
+	BuildDirections(FirstDependentDirection, NumDirections);
+
+	return true;
+}
+
+void FGridJumpPointTable::Empty()
+{
+	Distances.Empty();
+	Walkable.Empty();
+	NumDirections = 0;
+	FirstDependentDirection = 0;
+}
+
+bool FGridJumpPointTable::IsJumpPoint(int32 Column, int32 Row, int32 Direction) const
+{
+	const int32 DColumn = DirectionColumn[Direction];
+	const int32 DRow = DirectionRow[Direction];
+
+	// Same forced neighbor rules as the scanning jumps in JumpPointSearch.
+	if (NumDirections == 8)
+	{
+		if (DColumn != 0 && DRow != 0)
+		{
+			return (IsWalkable(Column - DColumn, Row + DRow) && !IsWalkable(Column - DColumn, Row))
+				|| (IsWalkable(Column + DColumn, Row - DRow) && !IsWalkable(Column, Row - DRow))
+				|| GetDistance(Column, Row, GetDirection(DColumn, 0)) > 0
+				|| GetDistance(Column, Row, GetDirection(0, DRow)) > 0;
+		}
+		if (DColumn != 0)
+			return (IsWalkable(Column + DColumn, Row + 1) && !IsWalkable(Column, Row + 1)) || (IsWalkable(Column + DColumn, Row - 1) && !IsWalkable(Column, Row - 1));
+
+		return (IsWalkable(Column + 1, Row + DRow) && !IsWalkable(Column + 1, Row)) || (IsWalkable(Column - 1, Row + DRow) && !IsWalkable(Column - 1, Row));
+	}
+
+	if (DColumn != 0)
+		return (IsWalkable(Column, Row - 1) && !IsWalkable(Column - DColumn, Row - 1)) || (IsWalkable(Column, Row + 1) && !IsWalkable(Column - DColumn, Row + 1));
+
+	return (IsWalkable(Column - 1, Row) && !IsWalkable(Column - 1, Row - DRow))
+		|| (IsWalkable(Column + 1, Row) && !IsWalkable(Column + 1, Row - DRow))
+		|| GetDistance(Column, Row, 0) > 0
+		|| GetDistance(Column, Row, 1) > 0;
+}
+
+int32 FGridJumpPointTable::ComputeDistance(int32 Column, int32 Row, int32 Direction) const
+{
+	const int32 NextColumn = Column + DirectionColumn[Direction];
+	const int32 NextRow = Row + DirectionRow[Direction];
+
+	if (!IsWalkable(NextColumn, NextRow))
+		return 0;
+	if (IsJumpPoint(NextColumn, NextRow, Direction))
+		return 1;
+
+	const int32 NextDistance = GetDistance(NextColumn, NextRow, Direction);
+	return NextDistance > 0 ? NextDistance + 1 : NextDistance - 1;
+}
+
+void FGridJumpPointTable::BuildDirections(int32 FirstDirection, int32 LastDirection)
+{
+	// Every ray ends on the tile whose next step in its direction leaves the grid.
+	TArray<FIntVector> Rays;
+	for (int32 Direction = FirstDirection; Direction < LastDirection; Direction++)
+	{
+		const int32 DColumn = DirectionColumn[Direction];
+		const int32 DRow = DirectionRow[Direction];
+		const int32 LastColumn = DColumn > 0 ? GridX - 1 : 0;
+		const int32 LastRow = DRow > 0 ? GridY - 1 : 0;
+
+		if (DColumn != 0)
+		{
+			for (int32 Row = 0; Row < GridY; Row++)
+				Rays.Emplace(LastColumn, Row, Direction);
+		}
+		if (DRow != 0)
+		{
+			for (int32 Column = 0; Column < GridX; Column++)
+			{
+				if (DColumn == 0 || Column != LastColumn)
+					Rays.Emplace(Column, LastRow, Direction);
+			}
+		}
+	}
+
+	ParallelFor(Rays.Num(), [&](int32 RayIndex)
+		{
+			const FIntVector& Ray = Rays[RayIndex];
+			const int32 Direction = Ray.Z;
+			for (int32 Column = Ray.X, Row = Ray.Y; IsInside(Column, Row); Column -= DirectionColumn[Direction], Row -= DirectionRow[Direction])
+				Distances[ToIndex(Column, Row) * NumDirections + Direction] = (int16)ComputeDistance(Column, Row, Direction);
+		});
+}
+
+void FGridJumpPointTable::UpdateTile(const FGridTileData& Tiles, int32 Index)
+{
+	if (!IsBuilt(Tiles.Num()) || Walkable[Index] == Tiles.Access[Index])
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_JumpPointTableUpdate);
+
+	Walkable[Index] = Tiles.Access[Index];
+
+	const int32 Column = ColumnStride == 1 ? Index % GridX : Index / GridY;
+	const int32 Row = ColumnStride == 1 ? Index / GridX : Index % GridY;
+
+	// Forced neighbor rules only look one tile around, so jump points can only change next to the tile.
+	TArray<FIntPoint, TInlineAllocator<9>> Seeds;
+	for (int32 SeedRow = Row - 1; SeedRow <= Row + 1; SeedRow++)
+	{
+		for (int32 SeedColumn = Column - 1; SeedColumn <= Column + 1; SeedColumn++)
+		{
+			if (IsInside(SeedColumn, SeedRow))
+				Seeds.Emplace(SeedColumn, SeedRow);
+		}
+	}
+
+	// Base distances changing sign turn tiles into dependent jump points or back.
+	TSet<FIntPoint> DependentSeeds;
+	DependentSeeds.Append(Seeds);
+
+	auto Process = [this](TArrayView<FIntPoint> DirectionSeeds, int32 Direction, TSet<FIntPoint>* ChangedJumpPoints)
+		{
+			// Seeds further along the ray first, tiles before them read their distances.
+			const int32 DColumn = DirectionColumn[Direction];
+			const int32 DRow = DirectionRow[Direction];
+			Algo::Sort(DirectionSeeds, [DColumn, DRow](const FIntPoint& A, const FIntPoint& B)
+				{
+					return A.X * DColumn + A.Y * DRow > B.X * DColumn + B.Y * DRow;
+				});
+
+			for (const FIntPoint& Seed : DirectionSeeds)
+				Propagate(Seed, Direction, ChangedJumpPoints);
+		};
+
+	for (int32 Direction = 0; Direction < FirstDependentDirection; Direction++)
+		Process(Seeds, Direction, &DependentSeeds);
+
+	TArray<FIntPoint> DependentSeedArray = DependentSeeds.Array();
+	for (int32 Direction = FirstDependentDirection; Direction < NumDirections; Direction++)
+		Process(DependentSeedArray, Direction, nullptr);
+}
+
+void FGridJumpPointTable::Propagate(const FIntPoint& Seed, int32 Direction, TSet<FIntPoint>* ChangedJumpPoints)
+{
+	const int32 DColumn = DirectionColumn[Direction];
+	const int32 DRow = DirectionRow[Direction];
+
+	for (int32 Column = Seed.X - DColumn, Row = Seed.Y - DRow; IsInside(Column, Row); Column -= DColumn, Row -= DRow)
+	{
+		int16& Distance = Distances[ToIndex(Column, Row) * NumDirections + Direction];
+		const int32 NewDistance = ComputeDistance(Column, Row, Direction);
+		if (NewDistance == Distance)
+			break;
+
+		if (ChangedJumpPoints && (Distance > 0) != (NewDistance > 0))
+			ChangedJumpPoints->Add(FIntPoint(Column, Row));
+
+		Distance = (int16)NewDistance;
+	}
+}
+
+void ADsGrid::SetJumpPointTablesEnabled(bool bEnabled)
+{
+	bJumpPointTablesEnabled = bEnabled;
+	BuildJumpPointTable();
+}
+
+int64 ADsGrid::GetJumpPointTablesAllocatedSize() const
+{
+	return JumpPointTable.IsValid() ? (int64)JumpPointTable->GetAllocatedSize() : 0;
+}
+
+void ADsGrid::BuildJumpPointTable()
+{
+	if (!bJumpPointTablesEnabled || GridType != EGridType::Square || Tiles.Num() == 0)
+	{
+		JumpPointTable.Reset();
+		return;
+	}
+
+	if (!JumpPointTable.IsValid())
+		JumpPointTable = MakeShared<FGridJumpPointTable>();
+
+	JumpPointTable->Build(Tiles, GridX, GridY, TileOrder, bSquareGridDiagonalAllowed);
+}
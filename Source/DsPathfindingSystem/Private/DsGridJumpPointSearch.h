@@ -0,0 +1,98 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DsGrid.h"
+
+/*
+* JPS+ jump distances of a square grid, see ADsGrid::SetJumpPointTablesEnabled.
+* For every tile and direction a distance > 0 is the number of steps to the next jump point,
+* a distance <= 0 is minus the number of walkable steps before a blocked tile or the grid border.
+* The goal is not part of the table, JumpPointSearch checks it against the distances at query time.
+* Walkability is the tile access only, queries that filter tiles scan instead.
+*
+* Directions are the column/row deltas in DirectionColumn/DirectionRow, straight ones first. 4 connected grids only store those four.
+* Stops in the dependent directions (diagonals, or row changes on 4 connected grids) depend on the distances
+* of the base directions, so base directions are always computed first.
+*/
+class FGridJumpPointTable
+{
+public:
+	static constexpr int32 DirectionColumn[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	static constexpr int32 DirectionRow[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+	/* Rebuilds every distance, rays are computed in parallel. Returns false and stays empty if the grid does not fit 16 bit distances. */
+	bool Build(const FGridTileData& Tiles, int32 InGridX, int32 InGridY, EGridTileOrder TileOrder, bool bDiagonal);
+
+	/* Recomputes the distances that depend on the tile after its access changed. Does nothing if it did not. */
+	void UpdateTile(const FGridTileData& Tiles, int32 Index);
+
+	void Empty();
+
+	FORCEINLINE bool IsBuilt(int32 NumTiles) const
+	{
+		return NumDirections > 0 && Walkable.Num() == NumTiles;
+	}
+
+	FORCEINLINE int32 GetDistance(int32 Column, int32 Row, int32 Direction) const
+	{
+		return Distances[ToIndex(Column, Row) * NumDirections + Direction];
+	}
+
+	static FORCEINLINE int32 GetDirection(int32 DColumn, int32 DRow)
+	{
+		if (DRow == 0)
+			return DColumn > 0 ? 0 : 1;
+		if (DColumn == 0)
+			return DRow > 0 ? 2 : 3;
+		return (DColumn > 0 ? 4 : 6) + (DRow > 0 ? 0 : 1);
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Distances.GetAllocatedSize() + Walkable.GetAllocatedSize();
+	}
+
+private:
+	FORCEINLINE int32 ToIndex(int32 Column, int32 Row) const
+	{
+		return Column * ColumnStride + Row * RowStride;
+	}
+
+	FORCEINLINE bool IsInside(int32 Column, int32 Row) const
+	{
+		return Column >= 0 && Row >= 0 && Column < GridX && Row < GridY;
+	}
+
+	FORCEINLINE bool IsWalkable(int32 Column, int32 Row) const
+	{
+		return IsInside(Column, Row) && Walkable[ToIndex(Column, Row)];
+	}
+
+	/* True if a jump in Direction stops on the walkable tile Column/Row */
+	bool IsJumpPoint(int32 Column, int32 Row, int32 Direction) const;
+
+	/* Distance of Column/Row from the distance of the next tile in Direction */
+	int32 ComputeDistance(int32 Column, int32 Row, int32 Direction) const;
+
+	/* Computes every ray of the directions [FirstDirection, LastDirection) from its far end backwards */
+	void BuildDirections(int32 FirstDirection, int32 LastDirection);
+
+	/* Recomputes the tiles before Seed in Direction until a distance does not change */
+	void Propagate(const FIntPoint& Seed, int32 Direction, TSet<FIntPoint>* ChangedJumpPoints);
+
+	TArray<int16> Distances;
+	TBitArray<> Walkable;
+	int32 GridX = 0;
+	int32 GridY = 0;
+	int32 ColumnStride = 0;
+	int32 RowStride = 0;
+	int32 NumDirections = 0;
+	int32 FirstDependentDirection = 0;
+};
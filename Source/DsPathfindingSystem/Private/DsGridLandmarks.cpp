@@ -0,0 +1,269 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#include "DsGridLandmarks.h"
+#include "DsGridSearch.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Grid~LandmarkBuild"), STAT_LandmarkBuild, STATGROUP_GRID);
+
+void FGridLandmarks::Build(const ADsGrid& Grid, int32 NumLandmarks, EGridHeuristicFunction InHeuristicFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LandmarkBuild);
+
+	const FGridTileData& TileData = Grid.GetTileData();
+	const int32 NumTiles = TileData.Num();
+
+	HeuristicFunction = InHeuristicFunction;
+	Landmarks.Reset();
+	FromLandmark.Reset();
+	ToLandmark.Reset();
+
+	EnterCosts.SetNumUninitialized(NumTiles);
+	int32 FirstWalkable = INDEX_NONE;
+	for (int32 Index = 0; Index < NumTiles; Index++)
+	{
+		EnterCosts[Index] = GetEnterCost(TileData, Index);
+		if (FirstWalkable == INDEX_NONE && TileData.Access[Index])
+			FirstWalkable = Index;
+	}
+
+	if (FirstWalkable == INDEX_NONE || NumLandmarks <= 0)
+		return;
+
+	// Farthest point selection: every landmark is the walkable tile farthest from the ones picked so far.
+	// Tiles no landmark reaches count as farthest, so disconnected areas get their own landmark.
+	TArray<float> Costs;
+	ComputeCosts(Grid, TileData, FirstWalkable, false, Costs);
+
+	int32 Candidate = FirstWalkable;
+	float CandidateCost = 0.0f;
+	for (int32 Index = 0; Index < NumTiles; Index++)
+	{
+		if (TileData.Access[Index] && Costs[Index] != MAX_flt && Costs[Index] > CandidateCost)
+		{
+			Candidate = Index;
+			CandidateCost = Costs[Index];
+		}
+	}
+
+	TArray<TArray<float>> FromCosts;
+	TArray<float> Separation;
+	Separation.Init(MAX_flt, NumTiles);
+
+	while (Candidate != INDEX_NONE && Landmarks.Num() < NumLandmarks)
+	{
+		Landmarks.Add(Candidate);
+		TArray<float>& LandmarkCosts = FromCosts.AddDefaulted_GetRef();
+		ComputeCosts(Grid, TileData, Candidate, false, LandmarkCosts);
+
+		Candidate = INDEX_NONE;
+		CandidateCost = 0.0f;
+		for (int32 Index = 0; Index < NumTiles; Index++)
+		{
+			if (!TileData.Access[Index])
+				continue;
+
+			Separation[Index] = FMath::Min(Separation[Index], LandmarkCosts[Index]);
+			if (Separation[Index] > CandidateCost)
+			{
+				Candidate = Index;
+				CandidateCost = Separation[Index];
+			}
+		}
+	}
+
+	const int32 Count = Landmarks.Num();
+	TArray<TArray<float>> ToCosts;
+	ToCosts.SetNum(Count);
+	// Workers read the same tiles as the caller, including the snapshot of a background refresh.
+	ParallelFor(Count, [&](int32 Landmark)
+		{
+			FGridReadScope ReadScope(&Grid, &TileData);
+			ComputeCosts(Grid, TileData, Landmarks[Landmark], true, ToCosts[Landmark]);
+		});
+
+	float MaxCost = 0.0f;
+	for (int32 Landmark = 0; Landmark < Count; Landmark++)
+	{
+		for (int32 Index = 0; Index < NumTiles; Index++)
+		{
+			if (FromCosts[Landmark][Index] != MAX_flt)
+				MaxCost = FMath::Max(MaxCost, FromCosts[Landmark][Index]);
+			if (ToCosts[Landmark][Index] != MAX_flt)
+				MaxCost = FMath::Max(MaxCost, ToCosts[Landmark][Index]);
+		}
+	}
+	Quantum = FMath::Max(MaxCost / (Unreachable - 1), KINDA_SMALL_NUMBER);
+
+	auto Quantise = [this](float Cost) -> uint16
+		{
+			if (Cost == MAX_flt)
+				return Unreachable;
+			return (uint16)FMath::Clamp(FMath::FloorToInt32(Cost / Quantum), 0, Unreachable - 1);
+		};
+
+	FromLandmark.SetNumUninitialized(NumTiles * Count);
+	ToLandmark.SetNumUninitialized(NumTiles * Count);
+	for (int32 Index = 0; Index < NumTiles; Index++)
+	{
+		for (int32 Landmark = 0; Landmark < Count; Landmark++)
+		{
+			FromLandmark[Index * Count + Landmark] = Quantise(FromCosts[Landmark][Index]);
+			ToLandmark[Index * Count + Landmark] = Quantise(ToCosts[Landmark][Index]);
+		}
+	}
+}
+
+bool FGridLandmarks::IsLowerBound(const FGridTileData& TileData) const
+{
+	if (TileData.Num() != EnterCosts.Num())
+		return false;
+
+	for (int32 Index = 0; Index < EnterCosts.Num(); Index++)
+	{
+		if (!IsLowerBound(TileData, Index))
+			return false;
+	}
+	return true;
+}
+
+void FGridLandmarks::ComputeCosts(const ADsGrid& Grid, const FGridTileData& TileData, int32 Landmark, bool bReverse, TArray<float>& OutCosts) const
+{
+	const FGridAdjacency& Adjacency = bReverse ? Grid.GetPredecessors(true) : Grid.GetAdjacency(true);
+
+	OutCosts.Init(MAX_flt, TileData.Num());
+
+	FScopedGridSearchScratch Scratch(TileData.Num());
+	Scratch->Visit(Landmark);
+	Scratch->PushOpen(Landmark);
+
+	while (Scratch->HasOpen())
+	{
+		const int32 CurrentIndex = Scratch->PopOpen();
+		FGridSearchNode& CurrentNode = Scratch->Visit(CurrentIndex);
+		CurrentNode.bClosed = true;
+		OutCosts[CurrentIndex] = CurrentNode.TraversalCost;
+
+		// Reverse edges enter the current tile, forward edges the neighbor
+		if (bReverse && !TileData.Access[CurrentIndex])
+			continue;
+
+		const FVector CurrentLocation = Grid.GetTileLocation(CurrentIndex);
+		for (int32 Edge = Adjacency.Begin(CurrentIndex); Edge < Adjacency.End(CurrentIndex); Edge++)
+		{
+			const int32 NeighborIndex = Adjacency.GetNeighbor(CurrentIndex, Edge);
+			if (!bReverse && !TileData.Access[NeighborIndex])
+				continue;
+
+			FGridSearchNode& NextNode = Scratch->Visit(NeighborIndex);
+			if (NextNode.bClosed)
+				continue;
+
+			const int32 EnteredIndex = bReverse ? CurrentIndex : NeighborIndex;
+			const float TraversalCost = CurrentNode.TraversalCost + Grid.GetStepDistance(HeuristicFunction, CurrentLocation, Grid.GetTileLocation(NeighborIndex))
+				+ TileData.Cost[EnteredIndex] * TileData.CostScale[EnteredIndex];
+			const bool bIsOpen = Scratch->IsOpen(NeighborIndex);
+			if (bIsOpen && TraversalCost >= NextNode.TraversalCost)
+				continue;
+
+			NextNode.TraversalCost = TraversalCost;
+			NextNode.TotalCost = TraversalCost;
+
+			if (bIsOpen)
+				Scratch->DecreaseKey(NeighborIndex);
+			else
+				Scratch->PushOpen(NeighborIndex);
+		}
+	}
+}
+
+void ADsGrid::SetLandmarksEnabled(bool bEnabled, int32 NumLandmarks, EGridHeuristicFunction HeuristicFunction)
+{
+	bLandmarksEnabled = bEnabled;
+	LandmarkCount = FMath::Max(NumLandmarks, 1);
+	LandmarkHeuristicFunction = HeuristicFunction;
+	BuildLandmarks();
+}
+
+bool ADsGrid::AreLandmarksReady() const
+{
+	return Landmarks.IsValid() && Landmarks->IsBuilt(Tiles.Num());
+}
+
+int64 ADsGrid::GetLandmarksAllocatedSize() const
+{
+	return Landmarks.IsValid() ? (int64)Landmarks->GetAllocatedSize() : 0;
+}
+
+void ADsGrid::BuildLandmarks()
+{
+	LandmarkRefresh.Reset();
+
+	if (!bLandmarksEnabled || Tiles.Num() == 0)
+	{
+		Landmarks.Reset();
+		return;
+	}
+
+	TSharedPtr<FGridLandmarks> NewLandmarks = MakeShared<FGridLandmarks>();
+	NewLandmarks->Build(*this, LandmarkCount, LandmarkHeuristicFunction);
+	Landmarks = NewLandmarks;
+}
+
+void ADsGrid::RefreshLandmarks()
+{
+	check(IsInGameThread());
+
+	// A running refresh is checked against the tiles when it arrives and restarts if edits made it too optimistic.
+	if (!bLandmarksEnabled || Tiles.Num() == 0 || LandmarkRefresh.IsValid())
+		return;
+
+	TSharedPtr<FGridLandmarkRefresh> Refresh = MakeShared<FGridLandmarkRefresh>();
+	LandmarkRefresh = Refresh;
+
+	const ADsGrid* GridPtr = this;
+	TWeakObjectPtr<ADsGrid> WeakGrid(this);
+	TWeakPtr<FGridLandmarkRefresh> WeakRefresh(Refresh);
+	Refresh->Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [GridPtr, WeakGrid, WeakRefresh, Snapshot = MakeShared<const FGridTileData>(Tiles), Count = LandmarkCount, HeuristicFunction = LandmarkHeuristicFunction]()
+		{
+			TSharedPtr<FGridLandmarks> NewLandmarks = MakeShared<FGridLandmarks>();
+			{
+				FGridReadScope ReadScope(GridPtr, &Snapshot.Get());
+				NewLandmarks->Build(*GridPtr, Count, HeuristicFunction);
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [WeakGrid, WeakRefresh, NewLandmarks]()
+				{
+					ADsGrid* Grid = WeakGrid.Get();
+					TSharedPtr<FGridLandmarkRefresh> Finished = WeakRefresh.Pin();
+					if (!Grid || !Finished.IsValid() || Grid->LandmarkRefresh != Finished)
+						return;
+
+					Grid->LandmarkRefresh.Reset();
+					if (NewLandmarks->IsLowerBound(Grid->Tiles))
+						Grid->Landmarks = NewLandmarks;
+					else
+						Grid->RefreshLandmarks();
+				});
+		}, UE::Tasks::ETaskPriority::BackgroundNormal);
+}
+
+const FGridLandmarks* ADsGrid::FindLandmarks(const FGridQueryContext& Context, EGridHeuristicFunction HeuristicFunction) const
+{
+	// The tables model the live tile attributes, filters only make paths more expensive.
+	if (!AreLandmarksReady()
+		|| &GetTileData() != &Tiles
+		|| HasCustomNodeBehavior()
+		|| !Context.Preferences.bBlockBorder
+		|| Context.Preferences.bOverrideNodeCostToOne
+		|| Landmarks->GetHeuristicFunction() != HeuristicFunction)
+		return nullptr;
+
+	return Landmarks.Get();
+}
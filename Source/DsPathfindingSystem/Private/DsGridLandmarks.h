@@ -0,0 +1,117 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+#include "DsGrid.h"
+
+/*
+* ALT (A*, landmarks, triangle inequality) tables, see ADsGrid::SetLandmarksEnabled.
+* Stores the exact path cost from every landmark to every tile and back, over the blocked border adjacency
+* with the tile attributes as costs. Step costs follow AStarSearch: distance between tile centers plus the cost of the entered tile.
+* Paths are directed (the entered tile pays), so both directions are kept and give the bounds
+*   cost(n, t) >= cost(L, t) - cost(L, n)   and   cost(n, t) >= cost(n, L) - cost(t, L)
+* Costs are stored as uint16 multiples of Quantum, rounded so the bounds stay admissible.
+* The bounds hold for any search whose costs are not lower than the ones the tables were built from.
+*/
+class FGridLandmarks
+{
+public:
+	static constexpr uint16 Unreachable = MAX_uint16;
+
+	/* Picks NumLandmarks spread out walkable tiles and computes their tables. Reads Grid.GetTileData(), so it can run inside a read scope. */
+	void Build(const ADsGrid& Grid, int32 NumLandmarks, EGridHeuristicFunction InHeuristicFunction);
+
+	FORCEINLINE bool IsBuilt(int32 NumTiles) const
+	{
+		return Landmarks.Num() > 0 && EnterCosts.Num() == NumTiles;
+	}
+
+	FORCEINLINE EGridHeuristicFunction GetHeuristicFunction() const
+	{
+		return HeuristicFunction;
+	}
+
+	FORCEINLINE const TArray<int32>& GetLandmarks() const
+	{
+		return Landmarks;
+	}
+
+	/* Lower bound of the path cost from From to To, 0 if no landmark tells anything */
+	FORCEINLINE float GetLowerBound(int32 From, int32 To) const
+	{
+		const int32 NumLandmarks = Landmarks.Num();
+		const uint16* FromLandmarkTo = FromLandmark.GetData() + To * NumLandmarks;
+		const uint16* FromLandmarkFrom = FromLandmark.GetData() + From * NumLandmarks;
+		const uint16* ToLandmarkTo = ToLandmark.GetData() + To * NumLandmarks;
+		const uint16* ToLandmarkFrom = ToLandmark.GetData() + From * NumLandmarks;
+
+		// Both values are rounded down, one quantum is subtracted for the value that may be up to a quantum larger.
+		int32 Bound = 0;
+		for (int32 Landmark = 0; Landmark < NumLandmarks; Landmark++)
+		{
+			if (FromLandmarkTo[Landmark] != Unreachable && FromLandmarkFrom[Landmark] != Unreachable)
+				Bound = FMath::Max(Bound, FromLandmarkTo[Landmark] - FromLandmarkFrom[Landmark] - 1);
+			if (ToLandmarkFrom[Landmark] != Unreachable && ToLandmarkTo[Landmark] != Unreachable)
+				Bound = FMath::Max(Bound, ToLandmarkFrom[Landmark] - ToLandmarkTo[Landmark] - 1);
+		}
+		return Bound * Quantum;
+	}
+
+	/* True if entering the tile costs at least as much as when the tables were built, so the bounds still hold */
+	FORCEINLINE bool IsLowerBound(const FGridTileData& TileData, int32 Index) const
+	{
+		return GetEnterCost(TileData, Index) >= EnterCosts[Index];
+	}
+
+	/* IsLowerBound for every tile */
+	bool IsLowerBound(const FGridTileData& TileData) const;
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Landmarks.GetAllocatedSize() + FromLandmark.GetAllocatedSize() + ToLandmark.GetAllocatedSize() + EnterCosts.GetAllocatedSize();
+	}
+
+private:
+	static FORCEINLINE float GetEnterCost(const FGridTileData& TileData, int32 Index)
+	{
+		return TileData.Access[Index] ? TileData.Cost[Index] * TileData.CostScale[Index] : MAX_flt;
+	}
+
+	/*
+	* Dijkstra from Landmark over the whole grid. Reverse follows edges backwards, so costs are from every tile to Landmark.
+	* TileData are the tiles Build read, tile locations come from the read scope of the calling thread.
+	*/
+	void ComputeCosts(const ADsGrid& Grid, const FGridTileData& TileData, int32 Landmark, bool bReverse, TArray<float>& OutCosts) const;
+
+	TArray<int32> Landmarks;
+	/* Quantised cost from landmark k to tile i at [i * Landmarks.Num() + k] */
+	TArray<uint16> FromLandmark;
+	/* Quantised cost from tile i to landmark k at [i * Landmarks.Num() + k] */
+	TArray<uint16> ToLandmark;
+	/* Cost of entering every tile at build time, MAX_flt if blocked */
+	TArray<float> EnterCosts;
+	float Quantum = 1.0f;
+	EGridHeuristicFunction HeuristicFunction = EGridHeuristicFunction::Octile;
+};
+
+/*
+* Background rebuild of the landmark tables from a tile snapshot.
+* The tables are handed to the grid on the game thread. Destroying the refresh waits for the worker.
+*/
+struct FGridLandmarkRefresh
+{
+	UE::Tasks::FTask Task;
+
+	~FGridLandmarkRefresh()
+	{
+		if (Task.IsValid())
+			Task.Wait();
+	}
+};
@@ -0,0 +1,197 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#include "DsGrid.h"
+#include "DsGridSearch.h"
+
+DECLARE_CYCLE_STAT(TEXT("Grid~MultiGoalSearch"), STAT_MultiGoalSearch, STATGROUP_GRID);
+
+FSearchResult ADsGrid::MultiGoalSearch(int32 StartIndex, const FGridGoalSet& Goals, FAStarPreferences Preferences, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction) const
+{
+	return MultiGoalSearchWithContext(StartIndex, Goals, MakeQueryContext(Preferences), bStopAtNeighborLocation, HeuristicFunction);
+}
+
+FSearchResult ADsGrid::MultiGoalSearchWithContext(int32 StartIndex, const FGridGoalSet& Goals, const FGridQueryContext& Context, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_MultiGoalSearch);
+
+	return DispatchGridNeighborKernel(GridType, bSquareGridDiagonalAllowed, Context.Preferences.bBlockBorder, [&](auto Kernel)
+		{
+			return DispatchGridCostPolicy(*this, Context, [&](auto Policy)
+				{
+					return MultiGoalSearchImpl<decltype(Kernel), decltype(Policy)>(StartIndex, Goals, Context, bStopAtNeighborLocation, HeuristicFunction, Policy);
+				});
+		});
+}
+
+template<typename KernelType, typename PolicyType>
+FSearchResult ADsGrid::MultiGoalSearchImpl(int32 StartIndex, const FGridGoalSet& Goals, const FGridQueryContext& Context, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction, const PolicyType& Policy) const
+{
+	const FAStarPreferences& Preferences = Context.Preferences;
+
+	if (!IsValidIndex(StartIndex))
+		return FSearchResult();
+
+	FSearchResult Result;
+	Result.bStopAtNeighborLocation = bStopAtNeighborLocation;
+
+	const FGridTileData& TileData = GetTileData();
+	const bool bHasTilePredicate = Goals.HasTilePredicate();
+
+	// Goals the connected components rule out are dropped before the search
+	TSet<int32> GoalIndexes;
+	GoalIndexes.Reserve(Goals.GoalIndexes.Num());
+	for (const int32 GoalIndex : Goals.GoalIndexes)
+	{
+		if (IsValidIndex(GoalIndex) && (GoalIndex == StartIndex || !IsGoalUnreachable(StartIndex, GoalIndex, Context, bStopAtNeighborLocation)))
+			GoalIndexes.Add(GoalIndex);
+	}
+
+	if (GoalIndexes.Num() == 0 && !bHasTilePredicate)
+		return Result;
+
+	auto IsGoal = [&](int32 Index) -> bool
+		{
+			if (GoalIndexes.Contains(Index))
+				return true;
+			if (!bHasTilePredicate)
+				return false;
+			if (Goals.GoalTileTypes.Contains(TileData.Type[Index]))
+				return true;
+			if (Goals.MaxGoalNodeCost >= Goals.MinGoalNodeCost && TileData.Cost[Index] >= Goals.MinGoalNodeCost && TileData.Cost[Index] <= Goals.MaxGoalNodeCost)
+				return true;
+			return Goals.GoalPredicate && Goals.GoalPredicate(Index);
+		};
+
+	// NodeBehavior overrides get a goal tile as EndIndex, see MultiGoalSearch. Predicate only sets use the first goal tile of the grid.
+	TArray<int32> EndGoals;
+	TArray<FVector> EndGoalLocations;
+	if (PolicyType::bUsesEndIndex)
+	{
+		for (const int32 GoalIndex : GoalIndexes)
+			EndGoals.Add(GoalIndex);
+		for (int32 Index = 0; EndGoals.Num() == 0 && Index < TileData.Num(); Index++)
+		{
+			if (IsGoal(Index))
+				EndGoals.Add(Index);
+		}
+		if (EndGoals.Num() == 0)
+			EndGoals.Add(StartIndex);
+		for (const int32 EndGoal : EndGoals)
+			EndGoalLocations.Add(GetTileLocation(EndGoal));
+	}
+
+	const FGridAdjacency& Adjacency = KernelType::GetAdjacency(*this);
+
+	// Goal the search may stop on at Index, -1 if none
+	auto FindReachedGoal = [&](int32 Index) -> int32
+		{
+			if (IsGoal(Index))
+				return Index;
+			if (!bStopAtNeighborLocation)
+				return -1;
+
+			int32 Goal = -1;
+			KernelType::ForEach(Adjacency, Index, [&](int32 NeighborIndex, ENeighborDirection Direction) -> bool
+				{
+					if (!IsGoal(NeighborIndex))
+						return true;
+					Goal = NeighborIndex;
+					return false;
+				});
+			return Goal;
+		};
+
+	const int32 StartGoal = FindReachedGoal(StartIndex);
+	if (StartGoal != -1)
+	{
+		Result.EndPoint = StartGoal;
+		Result.ResultState = ESearchResult::AlreadyAtGoal;
+		return Result;
+	}
+
+	// The closest target keeps the estimate a lower bound. With bStopAtNeighborLocation the targets are the tiles next to the goals.
+	TArray<FVector> TargetLocations;
+	if (!bHasTilePredicate && GoalIndexes.Num() <= Goals.MaxHeuristicGoals)
+	{
+		for (const int32 GoalIndex : GoalIndexes)
+		{
+			if (!bStopAtNeighborLocation)
+			{
+				TargetLocations.Add(GetTileLocation(GoalIndex));
+				continue;
+			}
+			for (const int32 TargetIndex : GetNeighborTilesAsArray(GoalIndex, Preferences.bBlockBorder))
+				TargetLocations.AddUnique(GetTileLocation(TargetIndex));
+		}
+	}
+
+	const float HeuristicScale = GetHeuristicScale(HeuristicFunction, Preferences);
+	auto Heuristic = [&](int32 Index, const FVector& Location) -> float
+		{
+			if (TargetLocations.Num() == 0)
+				return 0.0f;
+
+			float Closest = MAX_flt;
+			for (const FVector& TargetLocation : TargetLocations)
+				Closest = FMath::Min(Closest, GetHeuristic(HeuristicFunction, Location, TargetLocation, HeuristicScale));
+			return Closest;
+		};
+
+	FScopedGridSearchScratch GridGraph(GridX * GridY);
+	GridGraph->Visit(StartIndex);
+	GridGraph->PushOpen(StartIndex);
+
+	const auto Goal = MakeGridSearchGoal(FindReachedGoal, [&](int32 NeighborIndex) -> int32
+		{
+			if (IsGoal(NeighborIndex))
+				return NeighborIndex;
+			if (EndGoals.Num() == 1)
+				return EndGoals[0];
+
+			const FVector Location = GetTileLocation(NeighborIndex);
+			int32 Closest = 0;
+			float ClosestDistance = MAX_flt;
+			for (int32 Candidate = 0; Candidate < EndGoals.Num(); Candidate++)
+			{
+				const float Distance = FVector::DistSquared(Location, EndGoalLocations[Candidate]);
+				if (Distance < ClosestDistance)
+				{
+					Closest = Candidate;
+					ClosestDistance = Distance;
+				}
+			}
+			return EndGoals[Closest];
+		});
+
+	TArray<int32> ObstacleIndexes;
+	FGridAStarRun Run;
+	if (Preferences.bRecordObstacleIndexes)
+		Run.ObstacleIndexes = &ObstacleIndexes;
+
+	RunAStar<KernelType>(*GridGraph, Run, Context, HeuristicFunction, Policy, Goal, Heuristic);
+
+	switch (Run.Status)
+	{
+	case FGridAStarRun::EStatus::Found:
+		Result = RetraceSearch(*GridGraph, StartIndex, Run.LastIndex, Run.ReachedGoal, bStopAtNeighborLocation);
+		break;
+	case FGridAStarRun::EStatus::LimitExceeded:
+		// Partial path towards the goals like AStarSearch, no goal was reached so EndPoint is the tile it ends on
+		Result = RetraceSearch(*GridGraph, StartIndex, Run.LastIndex, Run.LastIndex, bStopAtNeighborLocation);
+		if (Preferences.bFailIfTotalNodeCostExceeded)
+			Result.ResultState = ESearchResult::SearchFail;
+		break;
+	default:
+		for (const int32 ObstacleIndex : ObstacleIndexes)
+			Result.ObstacleIndexes.AddUnique(ObstacleIndex);
+		break;
+	}
+
+	Result.NumForwardExpansions = Run.NumExpansions;
+	return Result;
+}
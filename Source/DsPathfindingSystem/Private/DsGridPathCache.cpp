@@ -0,0 +1,283 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#include "DsGridPathCache.h"
+#include "DsGridSearch.h"
+
+void FGridPathCache::SetLayout(int32 InGridX, int32 InGridY, EGridTileOrder InTileOrder)
+{
+	Empty();
+
+	GridX = InGridX;
+	GridY = InGridY;
+	TileOrder = InTileOrder;
+	RegionsX = FMath::DivideAndRoundUp(FMath::Max(GridX, 1), RegionSize);
+	RegionVersions.Init(0, RegionsX * FMath::DivideAndRoundUp(FMath::Max(GridY, 1), RegionSize));
+}
+
+void FGridPathCache::SetLimits(int32 InMaxEntries, int64 InMaxBytes)
+{
+	MaxEntries = FMath::Max(InMaxEntries, 0);
+	MaxBytes = FMath::Max<int64>(InMaxBytes, 0);
+	Trim(MaxEntries, MaxBytes);
+}
+
+const FSearchResult* FGridPathCache::Find(const FGridPathCacheKey& Key, uint32 GridVersion)
+{
+	const int32* Slot = Slots.Find(Key);
+	if (!Slot)
+	{
+		Misses++;
+		return nullptr;
+	}
+
+	const int32 Found = *Slot;
+	if (!IsValid(Entries[Found], GridVersion))
+	{
+		Remove(Found);
+		Invalidations++;
+		Misses++;
+		return nullptr;
+	}
+
+	Unlink(Found);
+	LinkNewest(Found);
+	Hits++;
+	return &Entries[Found].Result;
+}
+
+void FGridPathCache::Add(const FGridPathCacheKey& Key, const FSearchResult& Result, const FGridPathCacheDependency& Dependency, uint32 GridVersion)
+{
+	if (!IsEnabled())
+		return;
+
+	if (const int32* Existing = Slots.Find(Key))
+		Remove(*Existing);
+
+	const SIZE_T EntrySize = sizeof(FEntry)
+		+ Result.PathResults.GetAllocatedSize() + Result.PathIndexes.GetAllocatedSize() + Result.Parents.GetAllocatedSize()
+		+ Result.PathCosts.GetAllocatedSize() + Result.ObstacleIndexes.GetAllocatedSize()
+		+ Key.Preferences.PlayerIDsToIgnore.GetAllocatedSize() + Key.Preferences.TileTypesToIgnore.GetAllocatedSize() + Key.Preferences.TileIndexesToFilter.GetAllocatedSize();
+	if ((int64)EntrySize > MaxBytes)
+		return;
+
+	Trim(MaxEntries - 1, MaxBytes - (int64)EntrySize);
+
+	const int32 Slot = FreeSlots.Num() > 0 ? FreeSlots.Pop(EAllowShrinking::No) : Entries.AddDefaulted();
+	FEntry& Entry = Entries[Slot];
+	Entry.Key = Key;
+	Entry.Result = Result;
+	Entry.Dependency = Dependency;
+	Entry.GridVersion = GridVersion;
+	Entry.AllocatedSize = EntrySize;
+
+	Slots.Add(Key, Slot);
+	LinkNewest(Slot);
+	AllocatedSize += (int64)EntrySize;
+}
+
+void FGridPathCache::MarkTileChanged(int32 Index, uint32 GridVersion)
+{
+	if (RegionVersions.Num() == 0)
+		return;
+
+	const bool bRowMajor = TileOrder == EGridTileOrder::RowMajor;
+	const int32 Column = bRowMajor ? Index % GridX : Index / GridY;
+	const int32 Row = bRowMajor ? Index / GridX : Index % GridY;
+	const int32 Region = (Row / RegionSize) * RegionsX + Column / RegionSize;
+	if (RegionVersions.IsValidIndex(Region))
+		RegionVersions[Region] = GridVersion;
+}
+
+void FGridPathCache::Empty()
+{
+	Entries.Empty();
+	FreeSlots.Empty();
+	Slots.Empty();
+	Newest = INDEX_NONE;
+	Oldest = INDEX_NONE;
+	AllocatedSize = 0;
+
+	RegionVersions.Empty();
+	GridX = 0;
+	GridY = 0;
+	RegionsX = 0;
+}
+
+FGridPathCacheStats FGridPathCache::GetStats() const
+{
+	FGridPathCacheStats Stats;
+	Stats.NumEntries = Slots.Num();
+	Stats.AllocatedSize = AllocatedSize;
+	Stats.Hits = Hits;
+	Stats.Misses = Misses;
+	Stats.Evictions = Evictions;
+	Stats.Invalidations = Invalidations;
+	return Stats;
+}
+
+bool FGridPathCache::IsValid(const FEntry& Entry, uint32 CurrentGridVersion) const
+{
+	switch (Entry.Dependency.Kind)
+	{
+	case FGridPathCacheDependency::EKind::None:
+		return true;
+	case FGridPathCacheDependency::EKind::Grid:
+		return Entry.GridVersion == CurrentGridVersion;
+	case FGridPathCacheDependency::EKind::Regions:
+		break;
+	}
+
+	// Regions edited after the search have a newer version than the entry
+	for (int32 RectIndex = 0; RectIndex < Entry.Dependency.NumRects; RectIndex++)
+	{
+		const FIntRect& Rect = Entry.Dependency.Rects[RectIndex];
+		for (int32 RegionY = Rect.Min.Y / RegionSize; RegionY <= (Rect.Max.Y - 1) / RegionSize; RegionY++)
+		{
+			for (int32 RegionX = Rect.Min.X / RegionSize; RegionX <= (Rect.Max.X - 1) / RegionSize; RegionX++)
+			{
+				if (RegionVersions[RegionY * RegionsX + RegionX] > Entry.GridVersion)
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+void FGridPathCache::Remove(int32 Slot)
+{
+	Unlink(Slot);
+	Slots.Remove(Entries[Slot].Key);
+	AllocatedSize -= (int64)Entries[Slot].AllocatedSize;
+	Entries[Slot] = FEntry();
+	FreeSlots.Add(Slot);
+}
+
+void FGridPathCache::Unlink(int32 Slot)
+{
+	FEntry& Entry = Entries[Slot];
+	if (Entry.Newer != INDEX_NONE)
+		Entries[Entry.Newer].Older = Entry.Older;
+	else
+		Newest = Entry.Older;
+
+	if (Entry.Older != INDEX_NONE)
+		Entries[Entry.Older].Newer = Entry.Newer;
+	else
+		Oldest = Entry.Newer;
+
+	Entry.Newer = INDEX_NONE;
+	Entry.Older = INDEX_NONE;
+}
+
+void FGridPathCache::LinkNewest(int32 Slot)
+{
+	FEntry& Entry = Entries[Slot];
+	Entry.Newer = INDEX_NONE;
+	Entry.Older = Newest;
+	if (Newest != INDEX_NONE)
+		Entries[Newest].Newer = Slot;
+	Newest = Slot;
+	if (Oldest == INDEX_NONE)
+		Oldest = Slot;
+}
+
+void FGridPathCache::Trim(int32 InMaxEntries, int64 InMaxBytes)
+{
+	while (Oldest != INDEX_NONE && (Slots.Num() > InMaxEntries || AllocatedSize > InMaxBytes))
+	{
+		Remove(Oldest);
+		Evictions++;
+	}
+}
+
+FSearchResult ADsGrid::CachedAStarSearch(int32 StartIndex, int32 EndIndex, const FAStarPreferences& Preferences, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction) const
+{
+	if (!IsValidIndex(StartIndex) || !IsValidIndex(EndIndex))
+		return FSearchResult();
+
+	if (!PathCache->HasLayout(GridX, GridY, TileOrder))
+		PathCache->SetLayout(GridX, GridY, TileOrder);
+
+	const FGridPathCacheKey Key(StartIndex, EndIndex, bStopAtNeighborLocation, HeuristicFunction, Preferences);
+	if (const FSearchResult* Cached = PathCache->Find(Key, GridVersion))
+		return *Cached;
+
+	const FGridQueryContext Context = MakeQueryContext(Preferences);
+	FSearchResult Result = AStarSearchWithContext(StartIndex, EndIndex, Context, bStopAtNeighborLocation, HeuristicFunction);
+
+	// Every tile a search expands is at most PathCost away from the start (and from the end when bidirectional),
+	// no step costs less than MinStepCost, so the tiles it read lie within Radius steps of the endpoints.
+	FGridPathCacheDependency Dependency;
+	if (Result.ResultState == ESearchResult::AlreadyAtGoal)
+	{
+		Dependency.Kind = FGridPathCacheDependency::EKind::None;
+	}
+	else if (Result.ResultState == ESearchResult::SearchSuccess && Preferences.TotalNodeCostLimit < 0 && Preferences.bBlockBorder)
+	{
+		const FGridAdjacency& Adjacency = GetAdjacency(true);
+		float MinStepDistance = MAX_flt;
+		for (const int32 Endpoint : { StartIndex, EndIndex })
+		{
+			for (int32 Edge = Adjacency.Begin(Endpoint); Edge < Adjacency.End(Endpoint); Edge++)
+				MinStepDistance = FMath::Min(MinStepDistance, GetStepDistance(HeuristicFunction, GetTileLocation(Endpoint), GetTileLocation(Adjacency.GetNeighbor(Endpoint, Edge))));
+		}
+		const float MinStepCost = MinStepDistance + (Preferences.bOverrideNodeCostToOne ? 1.0f : Tiles.MinCost);
+
+		if (MinStepDistance != MAX_flt && MinStepCost > 0.0f)
+		{
+			const float PathCost = DispatchGridCostPolicy(*this, Context, [&](auto Policy)
+				{
+					float Cost = 0.0f;
+					int32 Previous = StartIndex;
+					for (const int32 Index : Result.PathIndexes)
+					{
+						const FGridStepAccess Access = Policy.GetAccess(Previous, Index, EndIndex);
+						Cost += GetStepDistance(HeuristicFunction, GetTileLocation(Previous), GetTileLocation(Index))
+							+ (Preferences.bOverrideNodeCostToOne ? 1.0f : Access.NodeCost * Access.NodeCostScale);
+						Previous = Index;
+					}
+					return Cost;
+				});
+
+			// One step for rounding and one for the tiles generated next to the expanded ones, the backward search of
+			// bStopAtNeighborLocation starts next to the end tile.
+			const int32 Radius = FMath::FloorToInt32(PathCost / MinStepCost) + 2;
+			auto AddRect = [&](int32 Index, int32 RectRadius)
+				{
+					const int32 Column = GetIndexColumn(Index);
+					const int32 Row = GetIndexRow(Index);
+					Dependency.Rects[Dependency.NumRects++] = FIntRect(
+						FMath::Max(Column - RectRadius, 0), FMath::Max(Row - RectRadius, 0),
+						FMath::Min(Column + RectRadius + 1, GridX), FMath::Min(Row + RectRadius + 1, GridY));
+				};
+
+			Dependency.Kind = FGridPathCacheDependency::EKind::Regions;
+			AddRect(StartIndex, Radius);
+			if (Preferences.bBidirectional)
+				AddRect(EndIndex, Radius + 1);
+		}
+	}
+
+	PathCache->Add(Key, Result, Dependency, GridVersion);
+	return Result;
+}
+
+void ADsGrid::SetPathCacheLimits(int32 MaxEntries, int64 MaxBytes)
+{
+	PathCache->SetLimits(MaxEntries, MaxBytes);
+}
+
+void ADsGrid::ClearPathCache()
+{
+	PathCache->Empty();
+}
+
+FGridPathCacheStats ADsGrid::GetPathCacheStats() const
+{
+	return PathCache->GetStats();
+}
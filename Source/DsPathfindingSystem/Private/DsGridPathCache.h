@@ -0,0 +1,160 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DsGrid.h"
+
+/*
+* Query an AStarSearch result is cached for
+*/
+struct FGridPathCacheKey
+{
+	int32 StartIndex;
+	int32 EndIndex;
+	bool bStopAtNeighborLocation;
+	EGridHeuristicFunction HeuristicFunction;
+	FAStarPreferences Preferences;
+	uint32 Hash;
+
+	FGridPathCacheKey()
+		: StartIndex(-1)
+		, EndIndex(-1)
+		, bStopAtNeighborLocation(false)
+		, HeuristicFunction(EGridHeuristicFunction::Octile)
+		, Hash(0)
+	{}
+
+	FGridPathCacheKey(int32 InStartIndex, int32 InEndIndex, bool bInStopAtNeighborLocation, EGridHeuristicFunction InHeuristicFunction, const FAStarPreferences& InPreferences)
+		: StartIndex(InStartIndex)
+		, EndIndex(InEndIndex)
+		, bStopAtNeighborLocation(bInStopAtNeighborLocation)
+		, HeuristicFunction(InHeuristicFunction)
+		, Preferences(InPreferences)
+	{
+		Hash = HashCombineFast(GetTypeHash(StartIndex), GetTypeHash(EndIndex));
+		Hash = HashCombineFast(Hash, (uint32)bStopAtNeighborLocation | ((uint32)HeuristicFunction << 1));
+		Hash = HashCombineFast(Hash, GetTypeHash(Preferences));
+	}
+
+	bool operator==(const FGridPathCacheKey& Other) const
+	{
+		return Hash == Other.Hash
+			&& StartIndex == Other.StartIndex
+			&& EndIndex == Other.EndIndex
+			&& bStopAtNeighborLocation == Other.bStopAtNeighborLocation
+			&& HeuristicFunction == Other.HeuristicFunction
+			&& Preferences == Other.Preferences;
+	}
+
+	friend FORCEINLINE uint32 GetTypeHash(const FGridPathCacheKey& Key)
+	{
+		return Key.Hash;
+	}
+};
+
+/*
+* Tiles a cached result was computed from.
+* Regions lists up to two rectangles of tile coordinates (Min inclusive, Max exclusive), the result is only valid
+* while no tile inside them changes. Grid results are valid until any tile changes, None results never expire.
+*/
+struct FGridPathCacheDependency
+{
+	enum class EKind : uint8
+	{
+		None,
+		Regions,
+		Grid
+	};
+
+	EKind Kind = EKind::Grid;
+	FIntRect Rects[2];
+	int32 NumRects = 0;
+};
+
+/*
+* Least recently used AStarSearch results with per region validation, see ADsGrid::SetPathCacheLimits.
+* The grid is split into RegionSize x RegionSize tile regions that remember the grid version of their last edit.
+* Game thread only.
+*/
+class FGridPathCache
+{
+public:
+	static constexpr int32 RegionSize = 16;
+
+	/* Matches the region table to the grid layout, drops every entry if it changed */
+	void SetLayout(int32 InGridX, int32 InGridY, EGridTileOrder InTileOrder);
+
+	FORCEINLINE bool HasLayout(int32 InGridX, int32 InGridY, EGridTileOrder InTileOrder) const
+	{
+		return GridX == InGridX && GridY == InGridY && TileOrder == InTileOrder && RegionVersions.Num() > 0;
+	}
+
+	FORCEINLINE bool IsEnabled() const
+	{
+		return MaxEntries > 0 && MaxBytes > 0;
+	}
+
+	void SetLimits(int32 InMaxEntries, int64 InMaxBytes);
+
+	/* Valid result for Key or nullptr. Out of date entries are dropped. Counts a hit or a miss. */
+	const FSearchResult* Find(const FGridPathCacheKey& Key, uint32 GridVersion);
+
+	void Add(const FGridPathCacheKey& Key, const FSearchResult& Result, const FGridPathCacheDependency& Dependency, uint32 GridVersion);
+
+	/* Called after GridVersion was bumped for an edit of the tile */
+	void MarkTileChanged(int32 Index, uint32 GridVersion);
+
+	/* Drops every entry and the region table, counters are kept */
+	void Empty();
+
+	FGridPathCacheStats GetStats() const;
+
+private:
+	struct FEntry
+	{
+		FGridPathCacheKey Key;
+		FSearchResult Result;
+		FGridPathCacheDependency Dependency;
+		/* Grid version the result was computed at */
+		uint32 GridVersion = 0;
+		SIZE_T AllocatedSize = 0;
+		/* Neighbors in the recency list, INDEX_NONE at the ends */
+		int32 Newer = INDEX_NONE;
+		int32 Older = INDEX_NONE;
+	};
+
+	bool IsValid(const FEntry& Entry, uint32 CurrentGridVersion) const;
+	void Remove(int32 Slot);
+	void Unlink(int32 Slot);
+	void LinkNewest(int32 Slot);
+	void Trim(int32 InMaxEntries, int64 InMaxBytes);
+
+	/* Entries by slot, free slots are reset and reused */
+	TArray<FEntry> Entries;
+	TArray<int32> FreeSlots;
+	TMap<FGridPathCacheKey, int32> Slots;
+	int32 Newest = INDEX_NONE;
+	int32 Oldest = INDEX_NONE;
+
+	/* Grid version of the last edit of every region, row-major by region */
+	TArray<uint32> RegionVersions;
+	int32 GridX = 0;
+	int32 GridY = 0;
+	int32 RegionsX = 0;
+	EGridTileOrder TileOrder = EGridTileOrder::RowMajor;
+
+	int32 MaxEntries = 256;
+	int64 MaxBytes = 4194304;
+	int64 AllocatedSize = 0;
+
+	int64 Hits = 0;
+	int64 Misses = 0;
+	int64 Evictions = 0;
+	int64 Invalidations = 0;
+};
@@ -0,0 +1,224 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#include "DsGridQueryService.h"
+#include "DsGridSearch.h"
+#include "Async/Async.h"
+
+void FGridQueryState::Complete(FSearchResult&& InResult)
+{
+	check(IsInGameThread());
+
+	if (bCancelled)
+		return;
+
+	Result = MoveTemp(InResult);
+	bComplete = true;
+	OnComplete.ExecuteIfBound(Result);
+}
+
+FGridQueryService::FGridQueryService(const ADsGrid& InGrid)
+	: Grid(InGrid)
+{}
+
+FGridQueryService::~FGridQueryService()
+{
+	Flush();
+}
+
+FGridQueryHandle FGridQueryService::AStarSearch(int32 StartIndex, int32 EndIndex, const FAStarPreferences& Preferences, FOnGridQueryComplete OnComplete, EGridQueryPriority Priority, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction)
+{
+	const ADsGrid* GridPtr = &Grid;
+	TSharedRef<const FGridQueryContext> Context = MakeShared<const FGridQueryContext>(Preferences, Grid.GetGridSize());
+	return Submit([GridPtr, Context, StartIndex, EndIndex, bStopAtNeighborLocation, HeuristicFunction]()
+		{
+			return GridPtr->AStarSearchWithContext(StartIndex, EndIndex, *Context, bStopAtNeighborLocation, HeuristicFunction);
+		}, MoveTemp(OnComplete), Priority);
+}
+
+FGridQueryHandle FGridQueryService::PathSearchAtRange(int32 StartIndex, int32 AtRange, const FAStarPreferences& Preferences, FOnGridQueryComplete OnComplete, EGridQueryPriority Priority)
+{
+	const ADsGrid* GridPtr = &Grid;
+	TSharedRef<const FGridQueryContext> Context = MakeShared<const FGridQueryContext>(Preferences, Grid.GetGridSize());
+	return Submit([GridPtr, Context, StartIndex, AtRange]()
+		{
+			return GridPtr->PathSearchAtRangeWithContext(StartIndex, AtRange, *Context);
+		}, MoveTemp(OnComplete), Priority);
+}
+
+FGridQueryHandle FGridQueryService::Submit(TFunction<FSearchResult()> Query, FOnGridQueryComplete OnComplete, EGridQueryPriority Priority)
+{
+	check(IsInGameThread());
+
+	PruneFinished();
+
+	TSharedPtr<FGridQueryState> State = MakeShared<FGridQueryState>();
+	State->OnComplete = MoveTemp(OnComplete);
+
+	FPendingQuery& PendingQuery = Pending.AddDefaulted_GetRef();
+	PendingQuery.State = State;
+
+	if (Grid.NodeBehaviorRequiresGameThread())
+	{
+		// NodeBehavior may touch game state, run it on the game thread against the live tiles.
+		TWeakObjectPtr<const ADsGrid> WeakGrid(&Grid);
+		AsyncTask(ENamedThreads::GameThread, [State, WeakGrid, Query = MoveTemp(Query)]()
+			{
+				if (State->bCancelled || !WeakGrid.IsValid())
+					return;
+
+				State->Complete(Query());
+			});
+		return FGridQueryHandle(State);
+	}
+
+	UE::Tasks::ETaskPriority TaskPriority = UE::Tasks::ETaskPriority::BackgroundNormal;
+	switch (Priority)
+	{
+	case EGridQueryPriority::Low:
+		TaskPriority = UE::Tasks::ETaskPriority::BackgroundLow;
+		break;
+	case EGridQueryPriority::Normal:
+		TaskPriority = UE::Tasks::ETaskPriority::BackgroundNormal;
+		break;
+	case EGridQueryPriority::High:
+		TaskPriority = UE::Tasks::ETaskPriority::BackgroundHigh;
+		break;
+	}
+
+	const ADsGrid* GridPtr = &Grid;
+	PendingQuery.Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [State, GridPtr, TileView = GetSnapshot(), Query = MoveTemp(Query)]()
+		{
+			if (State->bCancelled)
+				return;
+
+			FSearchResult Result;
+			{
+				FGridReadScope ReadScope(GridPtr, TileView.Get());
+				Result = Query();
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [State, Result = MoveTemp(Result)]() mutable
+				{
+					State->Complete(MoveTemp(Result));
+				});
+		}, TaskPriority);
+
+	return FGridQueryHandle(State);
+}
+
+void FGridQueryService::CancelAll()
+{
+	for (const FPendingQuery& PendingQuery : Pending)
+		PendingQuery.State->bCancelled = true;
+}
+
+void FGridQueryService::Flush()
+{
+	CancelAll();
+
+	for (const FPendingQuery& PendingQuery : Pending)
+	{
+		if (PendingQuery.Task.IsValid())
+			PendingQuery.Task.Wait();
+	}
+
+	Pending.Reset();
+	Snapshots.Reset();
+	ChangedTiles.Reset();
+}
+
+int32 FGridQueryService::GetNumPendingQueries() const
+{
+	int32 Count = 0;
+	for (const FPendingQuery& PendingQuery : Pending)
+	{
+		if (!PendingQuery.State->bCancelled && !PendingQuery.State->bComplete)
+			Count++;
+	}
+	return Count;
+}
+
+void FGridQueryService::MarkTileChanged(int32 Index, uint32 GridVersion)
+{
+	if (Snapshots.Num() == 0)
+		return;
+
+	// Past this many edits a full copy is cheaper than replaying them
+	if (ChangedTiles.Num() >= Grid.GetTileData().Num() / 4)
+	{
+		Snapshots.Reset();
+		ChangedTiles.Reset();
+		return;
+	}
+
+	ChangedTiles.Emplace(GridVersion, Index);
+}
+
+TSharedPtr<const FGridTileData> FGridQueryService::GetSnapshot()
+{
+	constexpr int32 MaxSnapshots = 2;
+
+	const FGridTileData& Tiles = Grid.GetTileData();
+	const uint32 GridVersion = Grid.GetGridVersion();
+	if (Snapshots.Num() > 0 && Snapshots.Last().Version == GridVersion)
+		return Snapshots.Last().Tiles;
+
+	// A snapshot only referenced here is no longer read by any query and can be patched with the edited tiles.
+	int32 Reused = INDEX_NONE;
+	for (int32 Entry = 0; Entry < Snapshots.Num() && Reused == INDEX_NONE; Entry++)
+	{
+		if (Snapshots[Entry].Tiles.GetSharedReferenceCount() == 1)
+			Reused = Entry;
+	}
+
+	FSnapshot Snapshot;
+	if (Reused != INDEX_NONE)
+	{
+		Snapshot = MoveTemp(Snapshots[Reused]);
+		Snapshots.RemoveAt(Reused);
+
+		FGridTileData& Patched = *Snapshot.Tiles;
+		for (const TPair<uint32, int32>& Change : ChangedTiles)
+		{
+			if (Change.Key > Snapshot.Version)
+			{
+				Patched.SetAttribute(Change.Value, Tiles.GetAttribute(Change.Value));
+				Patched.Z[Change.Value] = Tiles.Z[Change.Value];
+			}
+		}
+		Patched.MinCost = Tiles.MinCost;
+	}
+	else
+	{
+		// Every snapshot is still read by a query, the oldest stays alive with its queries only
+		if (Snapshots.Num() == MaxSnapshots)
+			Snapshots.RemoveAt(0);
+		Snapshot.Tiles = MakeShared<FGridTileData>(Tiles);
+	}
+	Snapshot.Version = GridVersion;
+	Snapshots.Add(Snapshot);
+
+	// Edits every remaining snapshot already has are not needed anymore
+	const uint32 OldestVersion = Snapshots[0].Version;
+	ChangedTiles.RemoveAll([OldestVersion](const TPair<uint32, int32>& Change)
+		{
+			return Change.Key <= OldestVersion;
+		});
+
+	return Snapshot.Tiles;
+}
+
+void FGridQueryService::PruneFinished()
+{
+	Pending.RemoveAll([](const FPendingQuery& PendingQuery)
+		{
+			// Cancelled queries stay tracked until their worker returned, Flush has to wait for them.
+			const bool bFinished = PendingQuery.State->bCancelled || PendingQuery.State->bComplete;
+			return bFinished && (!PendingQuery.Task.IsValid() || PendingQuery.Task.IsCompleted());
+		});
+}
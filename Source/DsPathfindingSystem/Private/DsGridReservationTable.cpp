@@ -0,0 +1,398 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#include "DsGridReservationTable.h"
+#include "DsGridFlowField.h"
+#include "DsGridSearch.h"
+
+DECLARE_CYCLE_STAT(TEXT("Grid~CooperativeSearch"), STAT_CooperativeSearch, STATGROUP_GRID);
+
+int32 FGridReservationTable::GetAgent(int32 Index, int32 Time) const
+{
+	if (const int32* AgentId = Slots.Find(MakeKey(Index, Time)))
+		return *AgentId;
+
+	const FHold* Held = Holds.Find(Index);
+	return Held && Time >= Held->Time ? Held->AgentId : INDEX_NONE;
+}
+
+bool FGridReservationTable::CanMove(int32 From, int32 To, int32 Time, int32 AgentId) const
+{
+	if (!IsFree(To, Time + 1, AgentId))
+		return false;
+
+	// The agent on To at Time must not come the other way
+	const int32 Other = GetAgent(To, Time);
+	return Other == INDEX_NONE || Other == AgentId || GetAgent(From, Time + 1) != Other;
+}
+
+bool FGridReservationTable::CanRest(int32 Index, int32 Time, int32 AgentId) const
+{
+	// Holds start at or before LatestTime, so the steps up to it cover them too
+	for (int32 Step = Time; Step <= FMath::Max(Time, LatestTime); Step++)
+	{
+		if (!IsFree(Index, Step, AgentId))
+			return false;
+	}
+	return true;
+}
+
+void FGridReservationTable::Reserve(int32 AgentId, int32 Index, int32 Time)
+{
+	const uint64 Key = MakeKey(Index, Time);
+	Slots.Add(Key, AgentId);
+	AgentSlots.FindOrAdd(AgentId).Add(Key);
+	LatestTime = FMath::Max(LatestTime, Time);
+}
+
+void FGridReservationTable::Hold(int32 AgentId, int32 Index, int32 Time)
+{
+	if (const int32* Previous = AgentHolds.Find(AgentId))
+		Holds.Remove(*Previous);
+
+	if (const FHold* Other = Holds.Find(Index))
+		AgentHolds.Remove(Other->AgentId);
+
+	FHold NewHold;
+	NewHold.AgentId = AgentId;
+	NewHold.Time = Time;
+	Holds.Add(Index, NewHold);
+	AgentHolds.Add(AgentId, Index);
+	LatestTime = FMath::Max(LatestTime, Time);
+}
+
+void FGridReservationTable::Release(int32 AgentId)
+{
+	if (const TArray<uint64>* Keys = AgentSlots.Find(AgentId))
+	{
+		for (const uint64 Key : *Keys)
+		{
+			const int32* Owner = Slots.Find(Key);
+			if (Owner && *Owner == AgentId)
+				Slots.Remove(Key);
+		}
+		AgentSlots.Remove(AgentId);
+	}
+
+	if (const int32* Held = AgentHolds.Find(AgentId))
+	{
+		Holds.Remove(*Held);
+		AgentHolds.Remove(AgentId);
+	}
+}
+
+void FGridReservationTable::Advance(int32 Steps)
+{
+	CurrentTime += FMath::Max(Steps, 0);
+	LatestTime = FMath::Max(LatestTime, CurrentTime);
+
+	const uint64 FirstKey = MakeKey(0, CurrentTime);
+	for (auto It = AgentSlots.CreateIterator(); It; ++It)
+	{
+		TArray<uint64>& Keys = It.Value();
+		for (int32 Slot = Keys.Num() - 1; Slot >= 0; Slot--)
+		{
+			if (Keys[Slot] < FirstKey)
+			{
+				Slots.Remove(Keys[Slot]);
+				Keys.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+			}
+		}
+
+		if (Keys.Num() == 0)
+			It.RemoveCurrent();
+	}
+}
+
+void FGridReservationTable::Empty()
+{
+	Slots.Empty();
+	Holds.Empty();
+	AgentSlots.Empty();
+	AgentHolds.Empty();
+	CurrentTime = 0;
+	LatestTime = 0;
+}
+
+FSearchResult ADsGrid::CooperativeSearch(const FCooperativeSearchQuery& Query, int32 Window, const TSharedPtr<const FGridFlowField>& Field)
+{
+	const FAStarPreferences& Preferences = Query.Preferences;
+	const int32 AgentId = Query.AgentId;
+	const int32 StartIndex = Query.StartIndex;
+	const int32 EndIndex = Query.EndIndex;
+
+	if (!IsValidIndex(StartIndex) || !IsValidIndex(EndIndex))
+		return FSearchResult();
+
+	FSearchResult Result;
+	Result.EndPoint = EndIndex;
+
+	FGridReservationTable& Table = *Reservations;
+	const int32 StartTime = Table.GetTime();
+
+	if (StartIndex == EndIndex)
+	{
+		Table.Hold(AgentId, StartIndex, StartTime);
+		Result.ResultState = ESearchResult::AlreadyAtGoal;
+		return Result;
+	}
+
+	// Exact costs to the goal without the other agents, the heuristic of WHCA*. Tiles it can not reach are skipped.
+	if (!Field.IsValid() || !Field->IsReachable(StartIndex))
+	{
+		Table.Hold(AgentId, StartIndex, StartTime);
+		return Result;
+	}
+
+	const FGridQueryContext Context = MakeQueryContext(Preferences);
+	const FGridAdjacency& Adjacency = GetAdjacency(Preferences.bBlockBorder);
+
+	// Waiting costs as much as the cheapest step, so waits are never free and never a detour
+	float WaitCost = MAX_flt;
+	for (int32 Edge = Adjacency.Begin(StartIndex); Edge < Adjacency.End(StartIndex); Edge++)
+		WaitCost = FMath::Min(WaitCost, GetStepDistance(Query.HeuristicFunction, GetTileLocation(StartIndex), GetTileLocation(Adjacency.GetNeighbor(StartIndex, Edge))));
+	WaitCost = (WaitCost == MAX_flt ? 0.0f : WaitCost) + (Preferences.bOverrideNodeCostToOne ? 1.0f : Tiles.MinCost);
+	WaitCost = FMath::Max(WaitCost, KINDA_SMALL_NUMBER);
+
+	struct FNode
+	{
+		int32 Index;
+		int32 Step;
+		int32 Parent;
+		float TraversalCost;
+		float TotalCost;
+		float NodeCost;
+		bool bClosed;
+	};
+
+	// Open entries keep the key they were pushed with, an improved node is pushed again and its older entries go stale
+	struct FOpenEntry
+	{
+		float TotalCost;
+		int32 Step;
+		int32 NodeIndex;
+	};
+
+	TArray<FNode> Nodes;
+	TMap<uint64, int32> NodeByState;
+	TArray<FOpenEntry> Open;
+
+	// Deeper nodes first on ties, they are closer to the end of the window
+	auto OpenPredicate = [](const FOpenEntry& First, const FOpenEntry& Second)
+		{
+			return First.TotalCost < Second.TotalCost || (First.TotalCost == Second.TotalCost && First.Step > Second.Step);
+		};
+
+	auto Relax = [&](int32 Index, int32 Step, int32 Parent, float TraversalCost, float NodeCost)
+		{
+			const uint64 State = ((uint64)(uint32)Step << 32) | (uint32)Index;
+			int32 NodeIndex = INDEX_NONE;
+			if (const int32* Found = NodeByState.Find(State))
+			{
+				NodeIndex = *Found;
+				if (Nodes[NodeIndex].bClosed || TraversalCost >= Nodes[NodeIndex].TraversalCost)
+					return;
+			}
+			else
+			{
+				NodeIndex = Nodes.AddUninitialized();
+				NodeByState.Add(State, NodeIndex);
+			}
+
+			FNode& Node = Nodes[NodeIndex];
+			Node.Index = Index;
+			Node.Step = Step;
+			Node.Parent = Parent;
+			Node.TraversalCost = TraversalCost;
+			Node.TotalCost = TraversalCost + Field->GetCostToGoal(Index);
+			Node.NodeCost = NodeCost;
+			Node.bClosed = false;
+
+			FOpenEntry Entry;
+			Entry.TotalCost = Node.TotalCost;
+			Entry.Step = Step;
+			Entry.NodeIndex = NodeIndex;
+			Open.HeapPush(Entry, OpenPredicate);
+		};
+
+	Relax(StartIndex, 0, INDEX_NONE, 0.0f, 0.0f);
+
+	int32 Reached = INDEX_NONE;
+	int32 NumExpansions = 0;
+
+	DispatchGridCostPolicy(*this, Context, [&](auto Policy)
+		{
+			while (Open.Num() > 0)
+			{
+				FOpenEntry Entry;
+				Open.HeapPop(Entry, OpenPredicate, EAllowShrinking::No);
+				const int32 CurrentNodeIndex = Entry.NodeIndex;
+				if (Nodes[CurrentNodeIndex].bClosed || Entry.TotalCost != Nodes[CurrentNodeIndex].TotalCost)
+					continue;
+
+				Nodes[CurrentNodeIndex].bClosed = true;
+				const FNode Current = Nodes[CurrentNodeIndex];
+				const int32 Time = StartTime + Current.Step;
+
+				if ((Current.Index == EndIndex && Table.CanRest(EndIndex, Time, AgentId)) || Current.Step >= Window)
+				{
+					Reached = CurrentNodeIndex;
+					break;
+				}
+
+				NumExpansions++;
+
+				if (Table.IsFree(Current.Index, Time + 1, AgentId))
+					Relax(Current.Index, Current.Step + 1, CurrentNodeIndex, Current.TraversalCost + WaitCost, 0.0f);
+
+				const FVector CurrentLocation = GetTileLocation(Current.Index);
+				for (int32 Edge = Adjacency.Begin(Current.Index); Edge < Adjacency.End(Current.Index); Edge++)
+				{
+					const int32 NeighborIndex = Adjacency.GetNeighbor(Current.Index, Edge);
+					if (!Field->IsReachable(NeighborIndex) || !Table.CanMove(Current.Index, NeighborIndex, Time, AgentId))
+						continue;
+
+					const FGridStepAccess Access = Policy.GetAccess(Current.Index, NeighborIndex, EndIndex, Adjacency.Directions[Edge]);
+					if (!Access.bAccess)
+						continue;
+
+					const float TraversalCost = Current.TraversalCost + GetStepDistance(Query.HeuristicFunction, CurrentLocation, GetTileLocation(NeighborIndex))
+						+ (Preferences.bOverrideNodeCostToOne ? 1.0f : Access.NodeCost * Access.NodeCostScale);
+					Relax(NeighborIndex, Current.Step + 1, CurrentNodeIndex, TraversalCost, Preferences.bOverrideNodeCostToOne ? 1.0f : Access.NodeCost);
+				}
+			}
+		});
+
+	Result.NumForwardExpansions = NumExpansions;
+
+	// Boxed in for the whole window, the agent stays where it is
+	if (Reached == INDEX_NONE)
+	{
+		Table.Hold(AgentId, StartIndex, StartTime);
+		return Result;
+	}
+
+	TArray<int32> States;
+	for (int32 NodeIndex = Reached; NodeIndex != INDEX_NONE; NodeIndex = Nodes[NodeIndex].Parent)
+		States.Insert(NodeIndex, 0);
+
+	// Waits are reserved but not repeated in the path, the time of the next entry tells the follower how long to stay
+	int32 Previous = StartIndex;
+	for (const int32 NodeIndex : States)
+	{
+		const FNode& Node = Nodes[NodeIndex];
+		Table.Reserve(AgentId, Node.Index, StartTime + Node.Step);
+		if (Node.Index == Previous)
+			continue;
+
+		Result.PathResults.Add(GetTileLocation(Node.Index));
+		Result.PathIndexes.Add(Node.Index);
+		Result.PathTimes.Add(StartTime + Node.Step);
+		Result.TotalNodeCost += Node.NodeCost;
+		Result.PathCosts.Add(Node.Index, Node.NodeCost);
+		Result.Parents.Add(Node.Index, Previous);
+		Previous = Node.Index;
+	}
+
+	const FNode& Last = Nodes[Reached];
+	if (Last.Index == EndIndex && Table.CanRest(EndIndex, StartTime + Last.Step, AgentId))
+	{
+		Table.Hold(AgentId, EndIndex, StartTime + Last.Step);
+	}
+	else
+	{
+		const FSearchResult Rest = Field->TracePath(*this, Last.Index);
+		for (int32 Step = 1; Step <= Rest.PathIndexes.Num(); Step++)
+			Result.PathTimes.Add(StartTime + Last.Step + Step);
+		Result.PathResults.Append(Rest.PathResults);
+		Result.PathIndexes.Append(Rest.PathIndexes);
+		Result.TotalNodeCost += Rest.TotalNodeCost;
+		Result.PathCosts.Append(Rest.PathCosts);
+		Result.Parents.Append(Rest.Parents);
+	}
+
+	Result.PathLength = Result.PathIndexes.Num();
+	Result.ResultState = Result.PathIndexes.Num() > 0 ? ESearchResult::SearchSuccess : ESearchResult::AlreadyAtGoal;
+	return Result;
+}
+
+TArray<FSearchResult> ADsGrid::CooperativeSearchBatch(const TArray<FCooperativeSearchQuery>& Queries, int32 Window)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CooperativeSearch);
+	check(IsInGameThread());
+
+	for (const FCooperativeSearchQuery& Query : Queries)
+		Reservations->Release(Query.AgentId);
+
+	// One field per goal. The cache keeps as many as it holds, the rest are built for this batch only
+	// so the agents do not evict each other's fields.
+	TArray<TSharedPtr<const FGridFlowField>> Fields;
+	auto FindField = [&](const FCooperativeSearchQuery& Query) -> TSharedPtr<const FGridFlowField>
+		{
+			if (!IsValidIndex(Query.EndIndex))
+				return nullptr;
+
+			for (const TSharedPtr<const FGridFlowField>& Field : Fields)
+			{
+				if (Field->Matches(Query.EndIndex, Query.Preferences, false, Query.HeuristicFunction))
+					return Field;
+			}
+
+			TSharedPtr<const FGridFlowField> Field;
+			if (Fields.Num() < FlowFieldCacheSize)
+			{
+				Field = FindOrBuildFlowField(Query.EndIndex, Query.Preferences, false, Query.HeuristicFunction);
+			}
+			else
+			{
+				TSharedPtr<FGridFlowField> Uncached = MakeShared<FGridFlowField>(*this, Query.EndIndex, Query.Preferences, false, Query.HeuristicFunction);
+				Uncached->bStale = true;
+				Field = Uncached;
+			}
+			Fields.Add(Field);
+			return Field;
+		};
+
+	TArray<FSearchResult> Results;
+	Results.Reserve(Queries.Num());
+	for (const FCooperativeSearchQuery& Query : Queries)
+		Results.Add(CooperativeSearch(Query, FMath::Max(Window, 1), Query.StartIndex != Query.EndIndex ? FindField(Query) : nullptr));
+	return Results;
+}
+
+void ADsGrid::AdvanceReservationTime(int32 Steps)
+{
+	Reservations->Advance(Steps);
+}
+
+int32 ADsGrid::GetReservationTime() const
+{
+	return Reservations->GetTime();
+}
+
+void ADsGrid::ReserveTile(int32 AgentId, int32 Index)
+{
+	if (IsValidIndex(Index))
+		Reservations->Hold(AgentId, Index, Reservations->GetTime());
+}
+
+int32 ADsGrid::GetTileReservation(int32 Index, int32 StepsAhead) const
+{
+	if (!IsValidIndex(Index))
+		return -1;
+	return Reservations->GetAgent(Index, Reservations->GetTime() + FMath::Max(StepsAhead, 0));
+}
+
+void ADsGrid::ReleaseReservations(int32 AgentId)
+{
+	Reservations->Release(AgentId);
+}
+
+void ADsGrid::ClearReservations()
+{
+	Reservations->Empty();
+}
@@ -0,0 +1,88 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DsGrid.h"
+
+/*
+* Space-time reservations of the cooperative searches, see ADsGrid::CooperativeSearchBatch.
+* A reservation gives one tile to one agent for one absolute time step. An agent that reached its goal
+* holds the tile from then on, so later plans route around it. Game thread only.
+*/
+class FGridReservationTable
+{
+public:
+	FORCEINLINE int32 GetTime() const
+	{
+		return CurrentTime;
+	}
+
+	/* Last time step any agent has a reservation for */
+	FORCEINLINE int32 GetLatestTime() const
+	{
+		return LatestTime;
+	}
+
+	/* Agent owning the tile at Time, INDEX_NONE if it is free */
+	int32 GetAgent(int32 Index, int32 Time) const;
+
+	FORCEINLINE bool IsFree(int32 Index, int32 Time, int32 AgentId) const
+	{
+		const int32 Owner = GetAgent(Index, Time);
+		return Owner == INDEX_NONE || Owner == AgentId;
+	}
+
+	/* True if the agent may step from From at Time to To at Time + 1 without meeting or swapping with another agent */
+	bool CanMove(int32 From, int32 To, int32 Time, int32 AgentId) const;
+
+	/* True if the agent may stay on the tile from Time on */
+	bool CanRest(int32 Index, int32 Time, int32 AgentId) const;
+
+	void Reserve(int32 AgentId, int32 Index, int32 Time);
+
+	/* Gives the tile to the agent from Time on, replaces the previous hold of the agent */
+	void Hold(int32 AgentId, int32 Index, int32 Time);
+
+	/* Drops every reservation and the hold of the agent */
+	void Release(int32 AgentId);
+
+	/* Moves the current time forward and forgets the past steps */
+	void Advance(int32 Steps);
+
+	void Empty();
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Slots.GetAllocatedSize() + Holds.GetAllocatedSize() + AgentSlots.GetAllocatedSize() + AgentHolds.GetAllocatedSize();
+	}
+
+private:
+	static FORCEINLINE uint64 MakeKey(int32 Index, int32 Time)
+	{
+		return ((uint64)(uint32)Time << 32) | (uint32)Index;
+	}
+
+	struct FHold
+	{
+		int32 AgentId;
+		int32 Time;
+	};
+
+	/* Agent by tile and time step */
+	TMap<uint64, int32> Slots;
+	/* Held tiles */
+	TMap<int32, FHold> Holds;
+	/* Keys of Slots per agent, for Release */
+	TMap<int32, TArray<uint64>> AgentSlots;
+	/* Tile held by an agent */
+	TMap<int32, int32> AgentHolds;
+
+	int32 CurrentTime = 0;
+	int32 LatestTime = 0;
+};
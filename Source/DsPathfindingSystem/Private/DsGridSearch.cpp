@@ -0,0 +1,55 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#include "DsGridSearch.h"
+
+namespace
+{
+	struct FGridSearchScratchPool
+	{
+		TArray<TUniquePtr<FGridSearchScratch>> Scratches;
+		int32 Depth = 0;
+	};
+
+	thread_local FGridSearchScratchPool GridSearchScratchPool;
+}
+
+thread_local const ADsGrid* FGridReadScope::CurrentGrid = nullptr;
+thread_local const FGridTileData* FGridReadScope::CurrentTiles = nullptr;
+
+FGridReadScope::FGridReadScope(const ADsGrid* InGrid, const FGridTileData* InTiles)
+	: PreviousGrid(CurrentGrid)
+	, PreviousTiles(CurrentTiles)
+{
+	CurrentGrid = InGrid;
+	CurrentTiles = InTiles;
+	if (InGrid)
+		InGrid->NumReadScopes.fetch_add(1, std::memory_order_relaxed);
+}
+
+FGridReadScope::~FGridReadScope()
+{
+	if (CurrentGrid)
+		CurrentGrid->NumReadScopes.fetch_sub(1, std::memory_order_relaxed);
+	CurrentGrid = PreviousGrid;
+	CurrentTiles = PreviousTiles;
+}
+
+FScopedGridSearchScratch::FScopedGridSearchScratch(int32 NumTiles)
+{
+	FGridSearchScratchPool& Pool = GridSearchScratchPool;
+	if (Pool.Depth == Pool.Scratches.Num())
+		Pool.Scratches.Add(MakeUnique<FGridSearchScratch>());
+
+	Scratch = Pool.Scratches[Pool.Depth++].Get();
+	Scratch->Begin(NumTiles);
+}
+
+FScopedGridSearchScratch::~FScopedGridSearchScratch()
+{
+	GridSearchScratchPool.Depth--;
+}
@@ -0,0 +1,651 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DsGrid.h"
+#include "DsGridLandmarks.h"
+
+/*
+* Per tile search state.
+* Only valid while Generation matches the owning scratch generation.
+*/
+struct FGridSearchNode
+{
+	uint32 Generation = 0;
+	int32 HeapIndex = INDEX_NONE;
+	int32 Parent = -1;
+	int32 ParentCount = 0;
+	float TraversalCost = 0.0f;
+	float HeuristicCost = 0.0f;
+	float TotalCost = 0.0f;
+	float NodeCost = 1.0f;
+	float NodeCostCount = 0.0f;
+	bool bClosed = false;
+};
+
+/*
+* Monotone bucket queue for non negative costs.
+* Entries are grouped by floor(Cost / BucketWidth). When every step cost is a multiple of the width
+* entries come out in exact cost order, finer costs are handled by the caller re-expanding improved nodes.
+*/
+class FGridBucketQueue
+{
+public:
+	void Reset(float InBucketWidth, int32 NumBuckets)
+	{
+		for (int32 Bucket = Current; Bucket < Buckets.Num(); Bucket++)
+			Buckets[Bucket].Reset();
+
+		if (Buckets.Num() < NumBuckets)
+			Buckets.SetNum(NumBuckets);
+
+		BucketWidth = FMath::Max(InBucketWidth, UE_KINDA_SMALL_NUMBER);
+		LastBucket = NumBuckets - 1;
+		Current = 0;
+		Count = 0;
+	}
+
+	FORCEINLINE bool IsEmpty() const
+	{
+		return Count == 0;
+	}
+
+	void Push(int32 Index, float Cost)
+	{
+		const int32 Bucket = FMath::Clamp(FMath::FloorToInt32(Cost / BucketWidth), Current, LastBucket);
+		Buckets[Bucket].Emplace(Index, Cost);
+		Count++;
+	}
+
+	bool Pop(int32& OutIndex, float& OutCost)
+	{
+		if (Count == 0)
+			return false;
+
+		while (Buckets[Current].Num() == 0)
+			Current++;
+
+		const FEntry Entry = Buckets[Current].Pop(EAllowShrinking::No);
+		Count--;
+		OutIndex = Entry.Index;
+		OutCost = Entry.Cost;
+		return true;
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		SIZE_T Size = Buckets.GetAllocatedSize();
+		for (const auto& Bucket : Buckets)
+			Size += Bucket.GetAllocatedSize();
+		return Size;
+	}
+
+private:
+	struct FEntry
+	{
+		int32 Index;
+		float Cost;
+
+		FEntry(int32 InIndex, float InCost)
+			: Index(InIndex)
+			, Cost(InCost)
+		{}
+	};
+
+	TArray<TArray<FEntry>> Buckets;
+	float BucketWidth = 1.0f;
+	int32 LastBucket = 0;
+	int32 Current = 0;
+	int32 Count = 0;
+};
+
+/*
+* Search state indexed directly by tile index.
+* Begin() bumps the generation, so stale entries from earlier searches are ignored without a clearing pass.
+* Storage is kept between searches and only grows.
+* The open set is a binary min-heap of tile indices keyed by TotalCost, every node
+* remembers its heap slot so membership is O(1) and decrease-key is O(log n).
+*/
+class FGridSearchScratch
+{
+public:
+	void Begin(int32 NumTiles)
+	{
+		if (Nodes.Num() < NumTiles)
+			Nodes.SetNum(NumTiles);
+
+		if (++Generation == 0)
+		{
+			// Generation wrapped around, old stamps could alias the new one.
+			for (FGridSearchNode& Node : Nodes)
+				Node.Generation = 0;
+			Generation = 1;
+		}
+
+		OpenHeap.Reset();
+		VisitOrder.Reset();
+	}
+
+	FORCEINLINE bool IsVisited(int32 Index) const
+	{
+		return Nodes[Index].Generation == Generation;
+	}
+
+	/* Returns the node for Index, resetting it if it was not touched during this search. */
+	FORCEINLINE FGridSearchNode& Visit(int32 Index)
+	{
+		FGridSearchNode& Node = Nodes[Index];
+		if (Node.Generation != Generation)
+		{
+			Node = FGridSearchNode();
+			Node.Generation = Generation;
+		}
+		return Node;
+	}
+
+	FORCEINLINE const FGridSearchNode* Find(int32 Index) const
+	{
+		return Nodes.IsValidIndex(Index) && IsVisited(Index) ? &Nodes[Index] : nullptr;
+	}
+
+	FORCEINLINE bool IsOpen(int32 Index) const
+	{
+		return IsVisited(Index) && Nodes[Index].HeapIndex != INDEX_NONE;
+	}
+
+	FORCEINLINE bool HasOpen() const
+	{
+		return OpenHeap.Num() > 0;
+	}
+
+	FORCEINLINE int32 PeekOpen() const
+	{
+		return OpenHeap[0];
+	}
+
+	FORCEINLINE int32 OpenNum() const
+	{
+		return OpenHeap.Num();
+	}
+
+	/* Adds a visited node to the open set using its current TotalCost. */
+	void PushOpen(int32 Index)
+	{
+		const int32 Slot = OpenHeap.Add(Index);
+		Nodes[Index].HeapIndex = Slot;
+		SiftUp(Slot);
+	}
+
+	/* Restores heap order after the TotalCost of an open node was lowered. */
+	void DecreaseKey(int32 Index)
+	{
+		SiftUp(Nodes[Index].HeapIndex);
+	}
+
+	int32 PopOpen()
+	{
+		const int32 Index = OpenHeap[0];
+		Nodes[Index].HeapIndex = INDEX_NONE;
+
+		const int32 Last = OpenHeap.Pop(EAllowShrinking::No);
+		if (OpenHeap.Num() > 0)
+		{
+			OpenHeap[0] = Last;
+			Nodes[Last].HeapIndex = 0;
+			SiftDown(0);
+		}
+		return Index;
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Nodes.GetAllocatedSize() + OpenHeap.GetAllocatedSize() + Buckets.GetAllocatedSize() + VisitOrder.GetAllocatedSize();
+	}
+
+	/* Open set for uniform cost searches */
+	FGridBucketQueue Buckets;
+	/* Tiles in the order they were first reached */
+	TArray<int32> VisitOrder;
+
+private:
+	FORCEINLINE float GetKey(int32 Slot) const
+	{
+		return Nodes[OpenHeap[Slot]].TotalCost;
+	}
+
+	FORCEINLINE void Place(int32 Slot, int32 Index)
+	{
+		OpenHeap[Slot] = Index;
+		Nodes[Index].HeapIndex = Slot;
+	}
+
+	void SiftUp(int32 Slot)
+	{
+		const int32 Index = OpenHeap[Slot];
+		const float Key = Nodes[Index].TotalCost;
+		while (Slot > 0)
+		{
+			const int32 ParentSlot = (Slot - 1) / 2;
+			if (!(Key < GetKey(ParentSlot)))
+				break;
+			Place(Slot, OpenHeap[ParentSlot]);
+			Slot = ParentSlot;
+		}
+		Place(Slot, Index);
+	}
+
+	void SiftDown(int32 Slot)
+	{
+		const int32 Count = OpenHeap.Num();
+		const int32 Index = OpenHeap[Slot];
+		const float Key = Nodes[Index].TotalCost;
+		while (true)
+		{
+			int32 Child = Slot * 2 + 1;
+			if (Child >= Count)
+				break;
+			if (Child + 1 < Count && GetKey(Child + 1) < GetKey(Child))
+				Child++;
+			if (!(GetKey(Child) < Key))
+				break;
+			Place(Slot, OpenHeap[Child]);
+			Slot = Child;
+		}
+		Place(Slot, Index);
+	}
+
+	TArray<FGridSearchNode> Nodes;
+	TArray<int32> OpenHeap;
+	uint32 Generation = 0;
+};
+
+/*
+* Borrows a search scratch from the calling thread's pool for the lifetime of the scope.
+* Every thread owns its own pool, nested searches (e.g. from NodeBehavior) get their own scratch.
+*/
+class FScopedGridSearchScratch
+{
+public:
+	explicit FScopedGridSearchScratch(int32 NumTiles);
+	~FScopedGridSearchScratch();
+
+	FScopedGridSearchScratch(const FScopedGridSearchScratch&) = delete;
+	FScopedGridSearchScratch& operator=(const FScopedGridSearchScratch&) = delete;
+
+	FORCEINLINE FGridSearchScratch& operator*() const { return *Scratch; }
+	FORCEINLINE FGridSearchScratch* operator->() const { return Scratch; }
+
+private:
+	FGridSearchScratch* Scratch;
+};
+
+/*
+* Makes the calling thread read Tiles instead of the grid's live tile data for the lifetime of the scope.
+* Used by async queries so NodeBehavior and the tile accessors see a consistent snapshot.
+* Open scopes are counted on the grid, GetTileData skips the thread local lookup while there are none.
+*/
+class FGridReadScope
+{
+public:
+	FGridReadScope(const ADsGrid* InGrid, const FGridTileData* InTiles);
+	~FGridReadScope();
+
+	FGridReadScope(const FGridReadScope&) = delete;
+	FGridReadScope& operator=(const FGridReadScope&) = delete;
+
+	/* Snapshot bound to Grid on this thread, nullptr if none */
+	static FORCEINLINE const FGridTileData* Find(const ADsGrid* Grid)
+	{
+		return CurrentGrid == Grid ? CurrentTiles : nullptr;
+	}
+
+private:
+	const ADsGrid* PreviousGrid;
+	const FGridTileData* PreviousTiles;
+
+	static thread_local const ADsGrid* CurrentGrid;
+	static thread_local const FGridTileData* CurrentTiles;
+};
+
+/*
+* Neighbor expansion specialised for one grid layout and border mode.
+* NumDirections is the full row size of the layout (4, 8 or 6). Full rows, which is every interior tile,
+* run a loop with a constant trip count the compiler can unroll. Rows cut by the border take the generic loop.
+* Function(NeighborIndex, Direction) returns false to stop the expansion.
+*/
+template<int32 InNumDirections, bool bInBlockBorder>
+struct TGridNeighborKernel
+{
+	static constexpr int32 NumDirections = InNumDirections;
+	static constexpr bool bBlockBorder = bInBlockBorder;
+
+	static FORCEINLINE const FGridAdjacency& GetAdjacency(const ADsGrid& Grid)
+	{
+		return Grid.GetAdjacency(bBlockBorder);
+	}
+
+	static FORCEINLINE const FGridAdjacency& GetPredecessors(const ADsGrid& Grid)
+	{
+		return Grid.GetPredecessors(bBlockBorder);
+	}
+
+	template<typename FunctionType>
+	static FORCEINLINE bool ForEach(const FGridAdjacency& Adjacency, int32 Index, FunctionType&& Function)
+	{
+		const int32 Begin = Adjacency.Begin(Index);
+		const int32 Count = Adjacency.End(Index) - Begin;
+		const int32* Offsets = Adjacency.Offsets.GetData() + Begin;
+		const ENeighborDirection* Directions = Adjacency.Directions.GetData() + Begin;
+
+		if (Count == NumDirections)
+		{
+			for (int32 Edge = 0; Edge < NumDirections; Edge++)
+			{
+				if (!Function(Index + Offsets[Edge], Directions[Edge]))
+					return false;
+			}
+			return true;
+		}
+
+		for (int32 Edge = 0; Edge < Count; Edge++)
+		{
+			if (!Function(Index + Offsets[Edge], Directions[Edge]))
+				return false;
+		}
+		return true;
+	}
+};
+
+/*
+* Picks the kernel for the grid layout once and calls Function with it.
+*/
+template<typename FunctionType>
+FORCEINLINE auto DispatchGridNeighborKernel(EGridType GridType, bool bSquareGridDiagonalAllowed, bool bBlockBorder, FunctionType&& Function)
+{
+	if (GridType == EGridType::Hex)
+	{
+		return bBlockBorder ? Function(TGridNeighborKernel<6, true>()) : Function(TGridNeighborKernel<6, false>());
+	}
+	else if (bSquareGridDiagonalAllowed)
+	{
+		return bBlockBorder ? Function(TGridNeighborKernel<8, true>()) : Function(TGridNeighborKernel<8, false>());
+	}
+	return bBlockBorder ? Function(TGridNeighborKernel<4, true>()) : Function(TGridNeighborKernel<4, false>());
+}
+
+/*
+* Access and cost of a step, what a cost policy returns
+*/
+struct FGridStepAccess
+{
+	bool bAccess;
+	float NodeCost;
+	float NodeCostScale;
+};
+
+/*
+* Cost policies are the second template parameter of the searches next to the neighbor kernel.
+* GetAccess(CurrentIndex, NeighborIndex, EndIndex, Direction) returns the step onto NeighborIndex, CurrentIndex is -1
+* for the access check of the goal. Indexes are valid tiles.
+*
+* FGridTilePolicy is the default NodeBehavior with the compiled tile filters, read inline from the tile arrays.
+*/
+struct FGridTilePolicy
+{
+	/* EndIndex is ignored, callers may skip working it out */
+	static constexpr bool bUsesEndIndex = false;
+
+	FGridTilePolicy(const ADsGrid& Grid, const FGridQueryContext& InContext)
+		: TileData(Grid.GetTileData())
+		, Context(InContext)
+		, bHasTileFilters(InContext.HasTileFilters())
+	{}
+
+	FORCEINLINE FGridStepAccess GetAccess(int32 CurrentIndex, int32 NeighborIndex, int32 EndIndex, ENeighborDirection Direction = ENeighborDirection::None) const
+	{
+		FGridStepAccess Step;
+		Step.bAccess = TileData.Access[NeighborIndex] && !(bHasTileFilters && Context.IsTileExcluded(NeighborIndex, TileData.Type[NeighborIndex]));
+		Step.NodeCost = TileData.Cost[NeighborIndex];
+		Step.NodeCostScale = TileData.CostScale[NeighborIndex];
+		return Step;
+	}
+
+	const FGridTileData& TileData;
+	const FGridQueryContext& Context;
+	const bool bHasTileFilters;
+};
+
+/*
+* Calls the virtual ADsGrid::NodeBehavior, for grids that opt in with UsesNodeBehavior
+*/
+struct FGridNodeBehaviorPolicy
+{
+	static constexpr bool bUsesEndIndex = true;
+
+	FGridNodeBehaviorPolicy(const ADsGrid& InGrid, const FGridQueryContext& InContext)
+		: Grid(InGrid)
+		, Context(InContext)
+	{}
+
+	FORCEINLINE FGridStepAccess GetAccess(int32 CurrentIndex, int32 NeighborIndex, int32 EndIndex, ENeighborDirection Direction = ENeighborDirection::None) const
+	{
+		const FNodeAttribute Attribute = Grid.NodeBehaviorWithContext(CurrentIndex, NeighborIndex, EndIndex, Context, Direction);
+		FGridStepAccess Step;
+		Step.bAccess = Attribute.bAccess != 0;
+		Step.NodeCost = Attribute.NodeCost;
+		Step.NodeCostScale = Attribute.NodeCostScale;
+		return Step;
+	}
+
+	const ADsGrid& Grid;
+	const FGridQueryContext& Context;
+};
+
+/*
+* Picks the cost policy for the grid once and calls Function with it.
+*/
+template<typename FunctionType>
+FORCEINLINE auto DispatchGridCostPolicy(const ADsGrid& Grid, const FGridQueryContext& Context, FunctionType&& Function)
+{
+	if (Grid.UsesNodeBehavior())
+		return Function(FGridNodeBehaviorPolicy(Grid, Context));
+	return Function(FGridTilePolicy(Grid, Context));
+}
+
+/*
+* State of an A* run between ADsGrid::RunAStar calls, the open and closed sets are in the scratch.
+* The caller pushes the start tile, sets the limits of the next call and reads the outcome.
+*/
+struct FGridAStarRun
+{
+	enum class EStatus : uint8
+	{
+		/* MaxExpansions or EndTime ended the call, the next call goes on */
+		Running,
+		/* LastIndex is a goal tile, ReachedGoal the goal it stands for */
+		Found,
+		/* The open set ran empty */
+		Exhausted,
+		/* Expanding LastIndex went over TotalNodeCostLimit */
+		LimitExceeded,
+	};
+
+	int32 MaxExpansions = MAX_int32;
+	/* FPlatformTime::Seconds() to return at, 0 for none */
+	double EndTime = 0.0;
+	/* Blocked neighbors are added here if set */
+	TArray<int32>* ObstacleIndexes = nullptr;
+
+	EStatus Status = EStatus::Running;
+	int32 LastIndex = INDEX_NONE;
+	int32 ReachedGoal = INDEX_NONE;
+	/* Expansions over every call */
+	int32 NumExpansions = 0;
+};
+
+/*
+* Goal of AStarSearch: EndIndex, or the tiles around it with bStopAtNeighborLocation.
+* Goal types give the goal a popped tile reaches (FindGoal, INDEX_NONE if none) and the EndIndex a cost policy gets for a step.
+*/
+struct FGridEndGoal
+{
+	FGridEndGoal(int32 InEndIndex, const TArray<int32>* InStopAtNeighbor)
+		: EndIndex(InEndIndex)
+		, StopAtNeighbor(InStopAtNeighbor)
+	{}
+
+	FORCEINLINE int32 FindGoal(int32 Index) const
+	{
+		const bool bReached = StopAtNeighbor ? StopAtNeighbor->Contains(Index) : Index == EndIndex;
+		return bReached ? EndIndex : INDEX_NONE;
+	}
+
+	FORCEINLINE int32 GetEndIndex(int32 NeighborIndex) const
+	{
+		return EndIndex;
+	}
+
+	const int32 EndIndex;
+	const TArray<int32>* StopAtNeighbor;
+};
+
+/*
+* Goal type built from two functions, see FGridEndGoal
+*/
+template<typename FindGoalType, typename GetEndIndexType>
+struct TGridSearchGoal
+{
+	FindGoalType FindGoal;
+	GetEndIndexType GetEndIndex;
+};
+
+template<typename FindGoalType, typename GetEndIndexType>
+FORCEINLINE TGridSearchGoal<std::decay_t<FindGoalType>, std::decay_t<GetEndIndexType>> MakeGridSearchGoal(FindGoalType&& FindGoal, GetEndIndexType&& GetEndIndex)
+{
+	return { Forward<FindGoalType>(FindGoal), Forward<GetEndIndexType>(GetEndIndex) };
+}
+
+/*
+* Heuristic of AStarSearch: GetHeuristic to the end tile, raised to the landmark bound when there are landmarks.
+* Heuristic types are called with the tile index and its location.
+*/
+struct FGridEndHeuristic
+{
+	FGridEndHeuristic(const ADsGrid& InGrid, EGridHeuristicFunction InHeuristicFunction, float InHeuristicScale, int32 InEndIndex, const FGridLandmarks* InLandmarks)
+		: Grid(InGrid)
+		, HeuristicFunction(InHeuristicFunction)
+		, HeuristicScale(InHeuristicScale)
+		, EndIndex(InEndIndex)
+		, EndLocation(InGrid.GetTileLocation(InEndIndex))
+		, Landmarks(InLandmarks)
+	{}
+
+	FORCEINLINE float operator()(int32 Index, const FVector& Location) const
+	{
+		const float Heuristic = Grid.GetHeuristic(HeuristicFunction, Location, EndLocation, HeuristicScale);
+		return Landmarks ? FMath::Max(Heuristic, Landmarks->GetLowerBound(Index, EndIndex)) : Heuristic;
+	}
+
+	const ADsGrid& Grid;
+	const EGridHeuristicFunction HeuristicFunction;
+	const float HeuristicScale;
+	const int32 EndIndex;
+	const FVector EndLocation;
+	const FGridLandmarks* Landmarks;
+};
+
+template<typename KernelType, typename PolicyType, typename GoalType, typename HeuristicType>
+void ADsGrid::RunAStar(FGridSearchScratch& Scratch, FGridAStarRun& Run, const FGridQueryContext& Context, EGridHeuristicFunction HeuristicFunction, const PolicyType& Policy, const GoalType& Goal, const HeuristicType& Heuristic) const
+{
+	const FAStarPreferences& Preferences = Context.Preferences;
+	const FGridAdjacency& Adjacency = KernelType::GetAdjacency(*this);
+
+	Run.Status = FGridAStarRun::EStatus::Running;
+
+	for (int32 Expansion = 0; Expansion < Run.MaxExpansions; Expansion++)
+	{
+		if (!Scratch.HasOpen())
+		{
+			Run.Status = FGridAStarRun::EStatus::Exhausted;
+			return;
+		}
+
+		const int32 CurrentIndex = Scratch.PeekOpen();
+		const int32 ReachedGoal = Goal.FindGoal(CurrentIndex);
+		if (ReachedGoal != INDEX_NONE)
+		{
+			Run.Status = FGridAStarRun::EStatus::Found;
+			Run.LastIndex = CurrentIndex;
+			Run.ReachedGoal = ReachedGoal;
+			return;
+		}
+
+		Scratch.PopOpen();
+		Run.NumExpansions++;
+		FGridSearchNode& CurrentNode = Scratch.Visit(CurrentIndex);
+		CurrentNode.bClosed = true;
+
+		const FVector CurrentLocation = GetTileLocation(CurrentIndex);
+		bool bLimitExceeded = false;
+
+		KernelType::ForEach(Adjacency, CurrentIndex, [&](int32 NeighborIndex, ENeighborDirection Direction) -> bool
+			{
+				const FGridStepAccess Access = Policy.GetAccess(CurrentIndex, NeighborIndex, PolicyType::bUsesEndIndex ? Goal.GetEndIndex(NeighborIndex) : -1, Direction);
+				if (!Access.bAccess)
+				{
+					if (Run.ObstacleIndexes)
+						Run.ObstacleIndexes->Add(NeighborIndex);
+					return true;
+				}
+
+				FGridSearchNode& NextNode = Scratch.Visit(NeighborIndex);
+				if (NextNode.bClosed)
+					return true;
+
+				const FVector NextLocation = GetTileLocation(NeighborIndex);
+				const float TraversalCost = CurrentNode.TraversalCost + GetStepDistance(HeuristicFunction, CurrentLocation, NextLocation)
+					+ (Preferences.bOverrideNodeCostToOne ? 1.0f : Access.NodeCost * Access.NodeCostScale);
+
+				const bool bIsOpen = Scratch.IsOpen(NeighborIndex);
+				if (bIsOpen && TraversalCost >= NextNode.TraversalCost)
+					return true;
+
+				NextNode.NodeCost = Preferences.bOverrideNodeCostToOne ? 1.0f : Access.NodeCost;
+				NextNode.TraversalCost = TraversalCost;
+				NextNode.Parent = CurrentIndex;
+				NextNode.NodeCostCount = CurrentNode.NodeCostCount + NextNode.NodeCost;
+				NextNode.ParentCount = CurrentNode.ParentCount + 1;
+				NextNode.HeuristicCost = Heuristic(NeighborIndex, NextLocation);
+				NextNode.TotalCost = NextNode.TraversalCost + NextNode.HeuristicCost;
+
+				if (Preferences.TotalNodeCostLimit >= 0 && NextNode.TotalCost > Preferences.TotalNodeCostLimit)
+				{
+					bLimitExceeded = true;
+					return false;
+				}
+
+				if (bIsOpen)
+					Scratch.DecreaseKey(NeighborIndex);
+				else
+					Scratch.PushOpen(NeighborIndex);
+				return true;
+			});
+
+		if (bLimitExceeded)
+		{
+			Run.Status = FGridAStarRun::EStatus::LimitExceeded;
+			Run.LastIndex = CurrentIndex;
+			return;
+		}
+
+		// Reading the clock every few expansions keeps its cost out of the slice
+		if (Run.EndTime > 0.0 && (Expansion & 7) == 7 && FPlatformTime::Seconds() >= Run.EndTime)
+			return;
+	}
+}
@@ -0,0 +1,218 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#include "DsGridTimeSlicedSearch.h"
+#include "DsGridSearch.h"
+#include "DsGridLandmarks.h"
+
+DECLARE_CYCLE_STAT(TEXT("Grid~TimeSlicedStep"), STAT_TimeSlicedStep, STATGROUP_GRID);
+
+FGridTimeSlicedSearch::FGridTimeSlicedSearch(const ADsGrid& InGrid, int32 InStartIndex, int32 InEndIndex, const FAStarPreferences& Preferences, bool bInStopAtNeighborLocation, EGridHeuristicFunction InHeuristicFunction)
+	: Grid(&InGrid)
+	, Context(InGrid.MakeQueryContext(Preferences))
+	, StartIndex(InStartIndex)
+	, EndIndex(InEndIndex)
+	, bStopAtNeighborLocation(bInStopAtNeighborLocation)
+	, HeuristicFunction(InHeuristicFunction)
+	, Scratch(MakeUnique<FGridSearchScratch>())
+{
+	TileChangedHandle = InGrid.OnTileChanged.AddRaw(this, &FGridTimeSlicedSearch::OnTileChanged);
+	LayoutChangedHandle = InGrid.OnLayoutChanged.AddRaw(this, &FGridTimeSlicedSearch::OnLayoutChanged);
+	Begin();
+}
+
+FGridTimeSlicedSearch::~FGridTimeSlicedSearch()
+{
+	if (const ADsGrid* GridPtr = Grid.Get())
+	{
+		GridPtr->OnTileChanged.Remove(TileChangedHandle);
+		GridPtr->OnLayoutChanged.Remove(LayoutChangedHandle);
+	}
+}
+
+void FGridTimeSlicedSearch::Restart()
+{
+	Begin();
+}
+
+void FGridTimeSlicedSearch::OnTileChanged(int32 Index)
+{
+	const ADsGrid* GridPtr = Grid.Get();
+	if (bComplete || bTilesChanged || !GridPtr)
+		return;
+
+	// Open and closed tiles were read, so were the blocked neighbors of closed tiles
+	if (Index == StartIndex || Scratch->IsVisited(Index))
+	{
+		bTilesChanged = true;
+		return;
+	}
+
+	const FGridAdjacency& Predecessors = GridPtr->GetPredecessors(Context.Preferences.bBlockBorder);
+	for (int32 Edge = Predecessors.Begin(Index); Edge < Predecessors.End(Index); Edge++)
+	{
+		const FGridSearchNode* Node = Scratch->Find(Predecessors.GetNeighbor(Index, Edge));
+		if (Node && Node->bClosed)
+		{
+			bTilesChanged = true;
+			return;
+		}
+	}
+}
+
+void FGridTimeSlicedSearch::OnLayoutChanged()
+{
+	bLayoutChanged = true;
+}
+
+void FGridTimeSlicedSearch::Begin()
+{
+	bComplete = false;
+	bTilesChanged = false;
+	bLayoutChanged = false;
+	NumRunExpansions = 0;
+	ObstacleIndexes.Reset();
+	StopAtNeighbor.Reset();
+
+	const ADsGrid* GridPtr = Grid.Get();
+	if (!GridPtr || !GridPtr->IsValidIndex(StartIndex) || !GridPtr->IsValidIndex(EndIndex))
+	{
+		Complete(FSearchResult());
+		return;
+	}
+
+	HeuristicScale = GridPtr->GetHeuristicScale(HeuristicFunction, Context.Preferences);
+	Landmarks = bStopAtNeighborLocation ? nullptr : GridPtr->FindLandmarks(Context, HeuristicFunction);
+
+	FSearchResult Pending;
+	Pending.EndPoint = EndIndex;
+	Pending.bStopAtNeighborLocation = bStopAtNeighborLocation;
+
+	if (bStopAtNeighborLocation)
+		StopAtNeighbor = GridPtr->GetNeighborTilesAsArray(EndIndex, Context.Preferences.bBlockBorder);
+
+	if (StartIndex == EndIndex || StopAtNeighbor.Contains(StartIndex))
+	{
+		Pending.ResultState = ESearchResult::AlreadyAtGoal;
+		Complete(MoveTemp(Pending));
+		return;
+	}
+
+	if (!bStopAtNeighborLocation)
+	{
+		const bool bEndAccess = DispatchGridCostPolicy(*GridPtr, Context, [&](auto Policy)
+			{
+				return Policy.GetAccess(-1, EndIndex, EndIndex).bAccess;
+			});
+		if (!bEndAccess)
+		{
+			Complete(MoveTemp(Pending));
+			return;
+		}
+	}
+
+	Scratch->Begin(GridPtr->GetGridSize());
+	Scratch->Visit(StartIndex);
+	Scratch->PushOpen(StartIndex);
+}
+
+bool FGridTimeSlicedSearch::Step(int32 MaxExpansions, double MaxMicroseconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TimeSlicedStep);
+
+	if (bComplete)
+		return true;
+
+	const ADsGrid* GridPtr = Grid.Get();
+	if (!GridPtr)
+	{
+		Complete(FSearchResult());
+		return true;
+	}
+
+	const FAStarPreferences& Preferences = Context.Preferences;
+
+	// A higher heuristic scale keeps the open nodes admissible, a lower one or other landmark tables do not
+	const float CurrentHeuristicScale = GridPtr->GetHeuristicScale(HeuristicFunction, Preferences);
+	const FGridLandmarks* CurrentLandmarks = bStopAtNeighborLocation ? nullptr : GridPtr->FindLandmarks(Context, HeuristicFunction);
+	const bool bHeuristicChanged = CurrentHeuristicScale < HeuristicScale || CurrentLandmarks != Landmarks;
+
+	if (bLayoutChanged || ((bTilesChanged || bHeuristicChanged) && (MaxRestarts < 0 || NumRestarts < MaxRestarts)))
+	{
+		NumRestarts++;
+		Begin();
+		if (bComplete)
+			return true;
+	}
+	bTilesChanged = false;
+	// Past the restart cap the replaced tables are not read again
+	if (CurrentLandmarks != Landmarks)
+		Landmarks = nullptr;
+
+	const FGridEndGoal Goal(EndIndex, bStopAtNeighborLocation ? &StopAtNeighbor : nullptr);
+	const FGridEndHeuristic Heuristic(*GridPtr, HeuristicFunction, HeuristicScale, EndIndex, Landmarks);
+
+	FGridAStarRun Run;
+	Run.MaxExpansions = MaxExpansions;
+	Run.EndTime = MaxMicroseconds > 0.0 ? FPlatformTime::Seconds() + MaxMicroseconds * 1e-6 : 0.0;
+	if (Preferences.bRecordObstacleIndexes)
+		Run.ObstacleIndexes = &ObstacleIndexes;
+
+	DispatchGridNeighborKernel(GridPtr->GetGridType(), GridPtr->IsSquareGridDiagonalAllowed(), Preferences.bBlockBorder, [&](auto Kernel)
+		{
+			DispatchGridCostPolicy(*GridPtr, Context, [&](auto Policy)
+				{
+					GridPtr->RunAStar<decltype(Kernel)>(*Scratch, Run, Context, HeuristicFunction, Policy, Goal, Heuristic);
+				});
+		});
+
+	NumRunExpansions += Run.NumExpansions;
+	NumExpansions += Run.NumExpansions;
+
+	switch (Run.Status)
+	{
+	case FGridAStarRun::EStatus::Found:
+		Complete(GridPtr->RetraceSearch(*Scratch, StartIndex, Run.LastIndex, EndIndex, bStopAtNeighborLocation));
+		return true;
+	case FGridAStarRun::EStatus::LimitExceeded:
+	{
+		// Over the cost limit the path leads to the tile whose expansion went past it
+		FSearchResult Partial = GridPtr->RetraceSearch(*Scratch, StartIndex, Run.LastIndex, EndIndex, bStopAtNeighborLocation);
+		if (Preferences.bFailIfTotalNodeCostExceeded)
+			Partial.ResultState = ESearchResult::SearchFail;
+		Complete(MoveTemp(Partial));
+		return true;
+	}
+	case FGridAStarRun::EStatus::Exhausted:
+	{
+		FSearchResult Failed;
+		Failed.EndPoint = EndIndex;
+		Failed.bStopAtNeighborLocation = bStopAtNeighborLocation;
+		for (const int32 ObstacleIndex : ObstacleIndexes)
+			Failed.ObstacleIndexes.AddUnique(ObstacleIndex);
+		Complete(MoveTemp(Failed));
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+const FSearchResult& FGridTimeSlicedSearch::Finish()
+{
+	while (!Step(MAX_int32))
+	{
+	}
+	return Result;
+}
+
+void FGridTimeSlicedSearch::Complete(FSearchResult&& InResult)
+{
+	Result = MoveTemp(InResult);
+	Result.NumForwardExpansions = NumRunExpansions;
+	bComplete = true;
+}
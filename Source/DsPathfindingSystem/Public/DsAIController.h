@@ -11,6 +11,7 @@
 #include "AIController.h"
 #include "Delegates/DelegateCombinations.h"
 #include "DsGrid_PathFollowingComponent.h"
+#include "DsGrid.h"
 #include "DsAIController.generated.h"
 
 DECLARE_MULTICAST_DELEGATE_OneParam(FOnGridPathFinished, AActor*);
@@ -39,6 +40,13 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|Navigation", Meta = (AdvancedDisplay = "bStopOnOverlap,bCanStrafe,bAllowPartialPath"))
 	virtual EPathFollowingRequestResult::Type GridBasedMoveToLocation(const TArray<FVector>& Dests, const TArray<int32>& Indexes, float AcceptanceRadius = -1);
 
+	/*
+	* Move through the path of a finished search (AStarSearch, FGridTimeSlicedSearch, ...).
+	* A path with PathTimes (CooperativeSearchBatch) waits on its tiles until the reservation time of Grid allows the next step.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|Navigation")
+	EPathFollowingRequestResult::Type GridBasedMoveToSearchResult(const FSearchResult& SearchResult, float AcceptanceRadius = -1, const ADsGrid* Grid = nullptr);
+
 	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|Navigation")
 	void AbortMovement();
 
@@ -85,7 +93,22 @@ public:
 	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|Navigation")
 	TArray<int32> GetTileIndexes() const { return TileIndexes; }
 
+	virtual void Tick(float DeltaSeconds) override;
+
 protected:
+	// True if the reservation time allows stepping onto TileIndexes[TileIndex]
+	bool CanEnterTile(int32 TileIndex) const;
+
 	uint32 bPauseMoveCalled : 1;
+	// Paused on a tile until the reservation time allows the next step
+	uint32 bWaitingForTime : 1;
+	// The timed path waits before its first step
+	uint32 bStartPending : 1;
 	TArray<int32> TileIndexes;
+	// Reservation time each entry of TileIndexes is entered at, empty for untimed paths
+	TArray<int32> TileTimes;
+	TWeakObjectPtr<const ADsGrid> TimingGrid;
+	int32 WaitSegmentIndex;
+	FSearchResult PendingResult;
+	float PendingAcceptanceRadius;
 };
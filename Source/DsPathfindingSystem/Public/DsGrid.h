@@ -13,6 +13,8 @@
 #include "DsGrid.generated.h"
 
 DECLARE_STATS_GROUP(TEXT("Grid"), STATGROUP_GRID, STATCAT_Advanced);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnGridTileChanged, int32);
 //DSPATHFINDINGSYSTEM_API DECLARE_LOG_CATEGORY_EXTERN(LogGridError, Error, All);
 
 /*
@@ -58,6 +60,11 @@ enum class EGridHeuristicFunction : uint8
 	Octile			UMETA(DisplayName = "Octile"),
 	Manhattan		UMETA(DisplayName = "Manhattan"),
 	Euclidean		UMETA(DisplayName = "Euclidean"),
+	/*
+	* Hex grids only, Octile on square grids. Counts hex steps from cube coordinates, steps pay the entered tile cost
+	* and nothing for the distance, so paths are in tile cost units and do not depend on TileScale.
+	*/
+	HexCube			UMETA(DisplayName = "Hex Cube"),
 };
 
 UENUM(BlueprintType)
@@ -112,10 +119,19 @@ struct DSPATHFINDINGSYSTEM_API FSearchResult
 	/* Stores all found obstacles indexes */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
 	TArray<int32> ObstacleIndexes;
+	/* Reservation time each PathIndexes entry is entered at, cooperative searches only */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	TArray<int32> PathTimes;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
 	int32 EndPoint;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
 	uint32 bStopAtNeighborLocation : 1;
+	/* Tiles expanded from the start side */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	int32 NumForwardExpansions;
+	/* Tiles expanded from the goal side, bidirectional searches only */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	int32 NumBackwardExpansions;
 	/* Search state */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
 	ESearchResult ResultState = ESearchResult::SearchFail;
@@ -125,6 +141,8 @@ struct DSPATHFINDINGSYSTEM_API FSearchResult
 		, PathLength(NULL)
 		, EndPoint(-1)
 		, bStopAtNeighborLocation(false)
+		, NumForwardExpansions(0)
+		, NumBackwardExpansions(0)
 		, ResultState(ESearchResult::SearchFail)
 	{};
 	FSearchResult(ESearchResult NewResultState)
@@ -132,6 +150,8 @@ struct DSPATHFINDINGSYSTEM_API FSearchResult
 		, PathLength(NULL)
 		, EndPoint(-1)
 		, bStopAtNeighborLocation(false)
+		, NumForwardExpansions(0)
+		, NumBackwardExpansions(0)
 		, ResultState(NewResultState)
 	{};
 
@@ -338,6 +358,12 @@ struct DSPATHFINDINGSYSTEM_API FAStarPreferences
 	uint32 bIgnoreEnemyUnitsIfCombatRatingExceeded : 1;
 	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
 	int32 TargetCombatRating;
+	/*
+	* AStarSearch grows frontiers from the start and the goal and stops once the best meeting point is proven optimal.
+	* Ignored when TotalNodeCostLimit is set, partial paths only make sense from the start side.
+	*/
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	uint32 bBidirectional : 1;
 
 	FAStarPreferences(AActor* NewAActor = nullptr)
 		: Actor(NewAActor)
@@ -352,6 +378,232 @@ struct DSPATHFINDINGSYSTEM_API FAStarPreferences
 		, bFailIfTotalNodeCostExceeded(false)
 		, bIgnoreEnemyUnitsIfCombatRatingExceeded(false)
 		, TargetCombatRating(5.0f)
+		, bBidirectional(false)
+	{}
+
+	/* True if both charge every step the same. Limits, obstacle recording and bBidirectional only shape the search and are not compared. */
+	bool HasSameCosts(const FAStarPreferences& Other) const
+	{
+		return Actor == Other.Actor
+			&& bOverrideNodeCostToOne == Other.bOverrideNodeCostToOne
+			&& bBlockBorder == Other.bBlockBorder
+			&& PlayerIDsToIgnore == Other.PlayerIDsToIgnore
+			&& bIncreaseTileCostOfPlayerCharacters == Other.bIncreaseTileCostOfPlayerCharacters
+			&& TileCostScale == Other.TileCostScale
+			&& TileTypesToIgnore == Other.TileTypesToIgnore
+			&& TileIndexesToFilter == Other.TileIndexesToFilter
+			&& IgnoreTileObstackle == Other.IgnoreTileObstackle
+			&& bIgnoreEnemyUnitsIfCombatRatingExceeded == Other.bIgnoreEnemyUnitsIfCombatRatingExceeded
+			&& TargetCombatRating == Other.TargetCombatRating;
+	}
+
+	bool operator==(const FAStarPreferences& Other) const
+	{
+		return HasSameCosts(Other)
+			&& bRecordObstacleIndexes == Other.bRecordObstacleIndexes
+			&& TotalNodeCostLimit == Other.TotalNodeCostLimit
+			&& bFailIfTotalNodeCostExceeded == Other.bFailIfTotalNodeCostExceeded
+			&& bBidirectional == Other.bBidirectional;
+	}
+
+	/* Fingerprint of every field, equal preferences hash equal */
+	friend uint32 GetTypeHash(const FAStarPreferences& Preferences)
+	{
+		uint32 Hash = PointerHash(Preferences.Actor.Get());
+		Hash = HashCombineFast(Hash, (uint32)Preferences.bOverrideNodeCostToOne | ((uint32)Preferences.bBlockBorder << 1) | ((uint32)Preferences.bIncreaseTileCostOfPlayerCharacters << 2)
+			| ((uint32)Preferences.bRecordObstacleIndexes << 3) | ((uint32)Preferences.IgnoreTileObstackle << 4) | ((uint32)Preferences.bFailIfTotalNodeCostExceeded << 5)
+			| ((uint32)Preferences.bIgnoreEnemyUnitsIfCombatRatingExceeded << 6) | ((uint32)Preferences.bBidirectional << 7));
+		Hash = HashCombineFast(Hash, GetTypeHash(Preferences.TileCostScale));
+		Hash = HashCombineFast(Hash, GetTypeHash(Preferences.TotalNodeCostLimit));
+		Hash = HashCombineFast(Hash, GetTypeHash(Preferences.TargetCombatRating));
+		for (const int32 PlayerID : Preferences.PlayerIDsToIgnore)
+			Hash = HashCombineFast(Hash, GetTypeHash(PlayerID));
+		for (const ETileType TileType : Preferences.TileTypesToIgnore)
+			Hash = HashCombineFast(Hash, (uint32)TileType);
+		for (const int32 TileIndex : Preferences.TileIndexesToFilter)
+			Hash = HashCombineFast(Hash, GetTypeHash(TileIndex));
+		return Hash;
+	}
+};
+
+/*
+* One query of a batched AStarSearch
+*/
+USTRUCT(BlueprintType)
+struct DSPATHFINDINGSYSTEM_API FAStarSearchQuery
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	int32 StartIndex;
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	int32 EndIndex;
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	FAStarPreferences Preferences;
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	bool bStopAtNeighborLocation;
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	EGridHeuristicFunction HeuristicFunction;
+
+	FAStarSearchQuery()
+		: StartIndex(-1)
+		, EndIndex(-1)
+		, bStopAtNeighborLocation(false)
+		, HeuristicFunction(EGridHeuristicFunction::Octile)
+	{}
+
+	FAStarSearchQuery(int32 InStartIndex, int32 InEndIndex, const FAStarPreferences& InPreferences, bool bInStopAtNeighborLocation = false, EGridHeuristicFunction InHeuristicFunction = EGridHeuristicFunction::Octile)
+		: StartIndex(InStartIndex)
+		, EndIndex(InEndIndex)
+		, Preferences(InPreferences)
+		, bStopAtNeighborLocation(bInStopAtNeighborLocation)
+		, HeuristicFunction(InHeuristicFunction)
+	{}
+};
+
+/*
+* Goals of ADsGrid::MultiGoalSearch. A tile is a goal if it is listed in GoalIndexes or matches any of the tile predicates.
+*/
+USTRUCT(BlueprintType)
+struct DSPATHFINDINGSYSTEM_API FGridGoalSet
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	TArray<int32> GoalIndexes;
+	/* Tiles of these types are goals */
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	TArray<ETileType> GoalTileTypes;
+	/* Tiles whose NodeCost lies in [MinGoalNodeCost, MaxGoalNodeCost] are goals, unused while MaxGoalNodeCost < MinGoalNodeCost */
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	float MinGoalNodeCost;
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	float MaxGoalNodeCost;
+	/*
+	* Up to this many GoalIndexes the search is guided by the closest goal.
+	* Larger sets and any tile predicate search without an estimate (Dijkstra), which is cheaper than a long minimum.
+	*/
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	int32 MaxHeuristicGoals;
+	/* Native only, called with the tile index */
+	TFunction<bool(int32)> GoalPredicate;
+
+	FGridGoalSet()
+		: MinGoalNodeCost(0.0f)
+		, MaxGoalNodeCost(-1.0f)
+		, MaxHeuristicGoals(16)
+	{}
+
+	FGridGoalSet(const TArray<int32>& InGoalIndexes)
+		: GoalIndexes(InGoalIndexes)
+		, MinGoalNodeCost(0.0f)
+		, MaxGoalNodeCost(-1.0f)
+		, MaxHeuristicGoals(16)
+	{}
+
+	/* True if goals are picked by tile type, cost or GoalPredicate and not only by index */
+	FORCEINLINE bool HasTilePredicate() const
+	{
+		return GoalTileTypes.Num() > 0 || MaxGoalNodeCost >= MinGoalNodeCost || GoalPredicate;
+	}
+};
+
+/*
+* One agent of ADsGrid::CooperativeSearchBatch
+*/
+USTRUCT(BlueprintType)
+struct DSPATHFINDINGSYSTEM_API FCooperativeSearchQuery
+{
+	GENERATED_BODY()
+
+	/* Owner of the reservations, unique per agent */
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	int32 AgentId;
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	int32 StartIndex;
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	int32 EndIndex;
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	FAStarPreferences Preferences;
+	UPROPERTY(BlueprintReadWrite, Category = "DsPathfindingSystem|Structs")
+	EGridHeuristicFunction HeuristicFunction;
+
+	FCooperativeSearchQuery()
+		: AgentId(-1)
+		, StartIndex(-1)
+		, EndIndex(-1)
+		, HeuristicFunction(EGridHeuristicFunction::Octile)
+	{}
+
+	FCooperativeSearchQuery(int32 InAgentId, int32 InStartIndex, int32 InEndIndex, const FAStarPreferences& InPreferences, EGridHeuristicFunction InHeuristicFunction = EGridHeuristicFunction::Octile)
+		: AgentId(InAgentId)
+		, StartIndex(InStartIndex)
+		, EndIndex(InEndIndex)
+		, Preferences(InPreferences)
+		, HeuristicFunction(InHeuristicFunction)
+	{}
+};
+
+/*
+* Result of ADsGrid::HierarchicalSearch.
+* Waypoints is the abstract path: start, the cluster entrances on the way, and the goal.
+* Result holds the tiles of the segments refined so far in the same layout as AStarSearch,
+* RefineHierarchicalPath appends the next ones.
+*/
+USTRUCT(BlueprintType)
+struct DSPATHFINDINGSYSTEM_API FHierarchicalPath
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "DsPathfindingSystem|Structs")
+	TArray<int32> Waypoints;
+	/* Segments between Waypoints already in Result */
+	UPROPERTY(BlueprintReadOnly, Category = "DsPathfindingSystem|Structs")
+	int32 NumRefinedSegments;
+	UPROPERTY(BlueprintReadOnly, Category = "DsPathfindingSystem|Structs")
+	FSearchResult Result;
+
+	FHierarchicalPath()
+		: NumRefinedSegments(0)
+	{}
+
+	FORCEINLINE bool IsFullyRefined() const
+	{
+		return NumRefinedSegments >= Waypoints.Num() - 1;
+	}
+};
+
+/*
+* Counters of the AStarSearch result cache, see ADsGrid::SetPathCacheLimits
+*/
+USTRUCT(BlueprintType)
+struct DSPATHFINDINGSYSTEM_API FGridPathCacheStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "DsPathfindingSystem|Structs")
+	int32 NumEntries;
+	/* Bytes held by the cached results */
+	UPROPERTY(BlueprintReadOnly, Category = "DsPathfindingSystem|Structs")
+	int64 AllocatedSize;
+	UPROPERTY(BlueprintReadOnly, Category = "DsPathfindingSystem|Structs")
+	int64 Hits;
+	UPROPERTY(BlueprintReadOnly, Category = "DsPathfindingSystem|Structs")
+	int64 Misses;
+	/* Entries dropped to stay inside the limits */
+	UPROPERTY(BlueprintReadOnly, Category = "DsPathfindingSystem|Structs")
+	int64 Evictions;
+	/* Entries found out of date because a tile they depend on changed */
+	UPROPERTY(BlueprintReadOnly, Category = "DsPathfindingSystem|Structs")
+	int64 Invalidations;
+
+	FGridPathCacheStats()
+		: NumEntries(0)
+		, AllocatedSize(0)
+		, Hits(0)
+		, Misses(0)
+		, Evictions(0)
+		, Invalidations(0)
 	{}
 };
 
@@ -428,6 +680,204 @@ struct DSPATHFINDINGSYSTEM_API FGridNode
 	{}
 };
 
+/*
+* Dense tile storage. Every array is addressed directly by tile index.
+* Tile XY locations are not stored, they are derived from the index (see ADsGrid::GetTileLocation).
+*/
+struct DSPATHFINDINGSYSTEM_API FGridTileData
+{
+	TBitArray<> Access;
+	TArray<float> Cost;
+	TArray<ETileType> Type;
+	TArray<float> CostScale;
+	/* World space Z of every tile */
+	TArray<float> Z;
+	/* Accessible tiles whose Cost * CostScale is not 1, maintained by SetAttribute and UpdateCostClass */
+	TBitArray<> NonUnitCost;
+	int32 NumNonUnitCost = 0;
+	/*
+	* Lower bound of Cost * CostScale over the accessible tiles, never negative.
+	* Edits only lower it, RefreshMinCost makes it exact again.
+	*/
+	float MinCost = 1.0f;
+
+	FORCEINLINE int32 Num() const { return Cost.Num(); }
+
+	void Init(int32 NumTiles, float InZ, const FNodeAttribute& Attribute = FNodeAttribute())
+	{
+		Access.Init(Attribute.bAccess != 0, NumTiles);
+		Cost.Init(Attribute.NodeCost, NumTiles);
+		Type.Init(Attribute.TileType, NumTiles);
+		CostScale.Init(Attribute.NodeCostScale, NumTiles);
+		Z.Init(InZ, NumTiles);
+
+		const bool bNonUnitCost = IsNonUnitCost(Attribute);
+		NonUnitCost.Init(bNonUnitCost, NumTiles);
+		NumNonUnitCost = bNonUnitCost ? NumTiles : 0;
+
+		MinCost = FMath::Max(Attribute.NodeCost * Attribute.NodeCostScale, 0.0f);
+	}
+
+	void Empty()
+	{
+		Access.Empty();
+		Cost.Empty();
+		Type.Empty();
+		CostScale.Empty();
+		Z.Empty();
+		NonUnitCost.Empty();
+		NumNonUnitCost = 0;
+		MinCost = 1.0f;
+	}
+
+	FORCEINLINE FNodeAttribute GetAttribute(int32 Index) const
+	{
+		return FNodeAttribute(Access[Index], Cost[Index], Type[Index], CostScale[Index]);
+	}
+
+	FORCEINLINE void SetAttribute(int32 Index, const FNodeAttribute& Attribute)
+	{
+		Access[Index] = Attribute.bAccess != 0;
+		Cost[Index] = Attribute.NodeCost;
+		Type[Index] = Attribute.TileType;
+		CostScale[Index] = Attribute.NodeCostScale;
+		UpdateCostClass(Index);
+	}
+
+	/* Call after writing Access, Cost or CostScale of a tile directly */
+	FORCEINLINE void UpdateCostClass(int32 Index)
+	{
+		const bool bNonUnitCost = IsNonUnitCost(GetAttribute(Index));
+		if (NonUnitCost[Index] != bNonUnitCost)
+		{
+			NonUnitCost[Index] = bNonUnitCost;
+			NumNonUnitCost += bNonUnitCost ? 1 : -1;
+		}
+		if (Access[Index])
+			MinCost = FMath::Min(MinCost, FMath::Max(Cost[Index] * CostScale[Index], 0.0f));
+	}
+
+	/* Recomputes MinCost from every accessible tile */
+	void RefreshMinCost()
+	{
+		float NewMinCost = MAX_flt;
+		for (int32 Index = 0; Index < Num(); Index++)
+		{
+			if (Access[Index])
+				NewMinCost = FMath::Min(NewMinCost, FMath::Max(Cost[Index] * CostScale[Index], 0.0f));
+		}
+		MinCost = NewMinCost == MAX_flt ? 0.0f : NewMinCost;
+	}
+
+	/* Every accessible tile costs exactly 1 to enter */
+	FORCEINLINE bool HasUniformCost() const { return NumNonUnitCost == 0; }
+
+	static FORCEINLINE bool IsNonUnitCost(const FNodeAttribute& Attribute)
+	{
+		return Attribute.bAccess && Attribute.NodeCost * Attribute.NodeCostScale != 1.0f;
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Access.GetAllocatedSize() + Cost.GetAllocatedSize() + Type.GetAllocatedSize() + CostScale.GetAllocatedSize() + Z.GetAllocatedSize() + NonUnitCost.GetAllocatedSize();
+	}
+};
+
+/*
+* Neighbor adjacency stored once per tile class.
+* Tiles at the same distance from each border (counted up to 2) with the same row parity have the same neighbors
+* relative to their own index, so a table only holds the rows of the classes plus one class byte per tile.
+* The edges of tile i are [Begin(i), End(i)), its neighbor along an edge is i + Offsets[Edge] (GetNeighbor)
+* and Directions holds the matching direction.
+* Only tiles GetNeighborIndexes would visit are stored, in its order: E, W, S, N, SE, SW, NW, NE.
+*/
+struct DSPATHFINDINGSYSTEM_API FGridAdjacency
+{
+	/* Class of every tile, owned by the grid and shared by its tables */
+	const uint8* TileClasses = nullptr;
+	int32 NumTiles = 0;
+	/* Edges of class c are [ClassBegin[c], ClassBegin[c + 1]) */
+	TArray<int32> ClassBegin;
+	TArray<int32> Offsets;
+	TArray<ENeighborDirection> Directions;
+
+	FORCEINLINE int32 Num() const { return NumTiles; }
+	FORCEINLINE int32 Begin(int32 Index) const { return ClassBegin[TileClasses[Index]]; }
+	FORCEINLINE int32 End(int32 Index) const { return ClassBegin[TileClasses[Index] + 1]; }
+	FORCEINLINE int32 GetNeighbor(int32 Index, int32 Edge) const { return Index + Offsets[Edge]; }
+
+	void Empty()
+	{
+		TileClasses = nullptr;
+		NumTiles = 0;
+		ClassBegin.Empty();
+		Offsets.Empty();
+		Directions.Empty();
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return ClassBegin.GetAllocatedSize() + Offsets.GetAllocatedSize() + Directions.GetAllocatedSize();
+	}
+};
+
+/*
+* FAStarPreferences compiled for a grid.
+* Built once and borrowed by const reference for every search, so the preference arrays are not copied per node.
+* Tile type, tile index and player filters are lookups.
+*/
+struct DSPATHFINDINGSYSTEM_API FGridQueryContext
+{
+	FGridQueryContext(const FAStarPreferences& InPreferences, int32 NumTiles);
+
+	const FAStarPreferences Preferences;
+
+	FORCEINLINE bool IsTileTypeIgnored(ETileType TileType) const
+	{
+		const uint8 Bit = (uint8)TileType;
+		return (IgnoredTileTypes[Bit >> 6] & (1ull << (Bit & 63))) != 0;
+	}
+
+	FORCEINLINE bool IsTileFiltered(int32 Index) const
+	{
+		return Index < FilteredTiles.Num() && FilteredTiles[Index];
+	}
+
+	FORCEINLINE bool IsPlayerIgnored(int32 PlayerID) const
+	{
+		return IgnoredPlayerIDs.Contains(PlayerID);
+	}
+
+	/* True if TileTypesToIgnore or TileIndexesToFilter can exclude tiles */
+	FORCEINLINE bool HasTileFilters() const
+	{
+		return FilteredTiles.Num() > 0 || Preferences.TileTypesToIgnore.Num() > 0;
+	}
+
+	/* True if the tile is excluded by TileTypesToIgnore or TileIndexesToFilter */
+	FORCEINLINE bool IsTileExcluded(int32 Index, ETileType TileType) const
+	{
+		return IsTileFiltered(Index) || IsTileTypeIgnored(TileType);
+	}
+
+private:
+	uint64 IgnoredTileTypes[4];
+	TBitArray<> FilteredTiles;
+	TSet<int32> IgnoredPlayerIDs;
+};
+
+class FGridQueryService;
+class FGridSearchScratch;
+struct FGridAStarRun;
+class FGridJumpPointTable;
+class FGridHierarchy;
+class FGridLandmarks;
+struct FGridLandmarkRefresh;
+class FGridFlowField;
+class FGridPathCache;
+class FGridComponents;
+class FGridReservationTable;
+
 UCLASS(Blueprintable)
 class DSPATHFINDINGSYSTEM_API ADsGrid : public AActor
 {
@@ -443,6 +893,9 @@ protected:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void BeginDestroy() override;
+
 public:
 	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|Grid")
 	inline bool GenerateGrid(EGridType InGridType, int32 InGridX, int32 InGridY, bool bIsSquareGridDiagonalAllowed = false, bool bUseCustomTileBounds = false, FBox CustomTileBounds = FBox(), EGridTileOrder InTileOrder = EGridTileOrder::ColumnMajor)
@@ -484,6 +937,18 @@ public:
 		return D * (dx + dy) + (FMath::Sqrt(2.0f) - 2 * D) * FMath::Min(dx, dy);
 	}
 
+	/*
+	* Hex steps between two tile centers times D, exact on hex grids with blocked borders.
+	* Tile centers are converted to axial coordinates of the odd-r layout (see GetTileLocation), the distance is the cube distance.
+	* Only the difference of the centers is used, so it does not depend on the tile order.
+	*/
+	FORCEINLINE float HexCubeDistance(FVector FirstVector, FVector SecondVector, float D = 1.0f) const
+	{
+		const int32 dr = FMath::RoundToInt32((SecondVector.Y - FirstVector.Y) * HexStepInverse.Y);
+		const int32 dq = FMath::RoundToInt32((SecondVector.X - FirstVector.X) * HexStepInverse.X - dr * 0.5f);
+		return D * ((FMath::Abs(dq) + FMath::Abs(dr) + FMath::Abs(dq + dr)) / 2);
+	}
+
 	FORCEINLINE float GetHeuristic(EGridHeuristicFunction HeuristicFunction, FVector FirstVector, FVector SecondVector, float D = 1.0f) const
 	{
 		switch (HeuristicFunction)
@@ -494,10 +959,33 @@ public:
 			return (float)ManhattanDistance(FirstVector, SecondVector);
 		case EGridHeuristicFunction::Euclidean:
 			return EuclideanDistance(FirstVector, SecondVector);
+		case EGridHeuristicFunction::HexCube:
+			return GridType == EGridType::Hex ? HexCubeDistance(FirstVector, SecondVector, D) : OctileDistance(FirstVector, SecondVector);
 		}
 		return OctileDistance(FirstVector, SecondVector, D);
 	}
 
+	/* Distance part of a step cost between neighboring tiles. HexCube steps on hex grids only pay the entered tile. */
+	FORCEINLINE float GetStepDistance(EGridHeuristicFunction HeuristicFunction, FVector FirstVector, FVector SecondVector) const
+	{
+		if (HeuristicFunction == EGridHeuristicFunction::HexCube && GridType == EGridType::Hex)
+			return 0.0f;
+		return GetHeuristic(HeuristicFunction, FirstVector, SecondVector);
+	}
+
+	/*
+	* D to pass to GetHeuristic for a search. HexCube steps cost at least the cheapest tile, or 1 with bOverrideNodeCostToOne.
+	* A NodeBehavior override may charge less than the tiles (HasCustomNodeBehavior), the estimate is 0 then.
+	*/
+	FORCEINLINE float GetHeuristicScale(EGridHeuristicFunction HeuristicFunction, const FAStarPreferences& Preferences) const
+	{
+		if (HeuristicFunction != EGridHeuristicFunction::HexCube || GridType != EGridType::Hex)
+			return 1.0f;
+		if (Preferences.bOverrideNodeCostToOne)
+			return 1.0f;
+		return HasCustomNodeBehavior() ? 0.0f : GetTileData().MinCost;
+	}
+
 public:
 	/*
 	* Main pathfinding function
@@ -511,6 +999,203 @@ public:
 		return AStarSearch(StartIndex, EndIndex, Preferences, bStopAtNeighborLocation, HeuristicFunction);
 	}
 
+	/*
+	* Jump Point Search on square grids, 4 or 8 connected depending on IsSquareGridDiagonalAllowed.
+	* Returns the same optimal path cost as AStarSearch while only pushing jump points to the open set,
+	* the result lists every tile of the path like AStarSearch does.
+	* Falls back to AStarSearch on hex grids, wrapped borders, non uniform tile costs, HasCustomNodeBehavior,
+	* bStopAtNeighborLocation, TotalNodeCostLimit and bRecordObstacleIndexes.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	FSearchResult JumpPointSearch(int32 StartIndex, int32 EndIndex, FAStarPreferences Preferences, bool bStopAtNeighborLocation = false, EGridHeuristicFunction HeuristicFunction = EGridHeuristicFunction::Octile) const;
+
+	/*
+	* JPS+ mode for static maps. Precomputes per tile jump distances so JumpPointSearch reads them instead of scanning.
+	* Tables are built in parallel by GenerateGridEx and Resize, and locally updated when the access of a tile changes.
+	* Queries with TileTypesToIgnore or TileIndexesToFilter and async queries still scan.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void SetJumpPointTablesEnabled(bool bEnabled);
+
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	bool AreJumpPointTablesEnabled() const { return bJumpPointTablesEnabled; }
+
+	/* Memory used by the JPS+ tables in bytes */
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	int64 GetJumpPointTablesAllocatedSize() const;
+
+	/*
+	* HPA* layer. Splits the grid into ClusterSize x ClusterSize clusters and precomputes their entrances and
+	* the path costs between them. Step costs use HeuristicFunction like AStarSearch does.
+	* Clusters whose tiles change are rebuilt with their neighbors once per frame on the game thread, or by UpdateHierarchy.
+	* HierarchicalSearch runs AStarSearch until the rebuild is done.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void SetHierarchyEnabled(bool bEnabled, int32 ClusterSize = 16, EGridHeuristicFunction HeuristicFunction = EGridHeuristicFunction::Octile);
+
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	bool IsHierarchyEnabled() const { return bHierarchyEnabled; }
+
+	/* Rebuilds the clusters changed since the last update right away, game thread only */
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void UpdateHierarchy();
+
+	/* Memory used by the HPA* clusters in bytes */
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	int64 GetHierarchyAllocatedSize() const;
+
+	/*
+	* ALT heuristic. Picks NumLandmarks spread out tiles and precomputes the path costs from and to each of them.
+	* AStarSearch then raises HeuristicFunction to the triangle inequality bounds of the landmarks, so walls and costly terrain
+	* no longer make it open most of the map. Costs are stored as 16 bit values, 4 * NumLandmarks + 4 bytes per tile.
+	* Used by queries with the same HeuristicFunction, blocked borders, no bOverrideNodeCostToOne, no bStopAtNeighborLocation
+	* and no HasCustomNodeBehavior. Async queries search without them.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void SetLandmarksEnabled(bool bEnabled, int32 NumLandmarks = 8, EGridHeuristicFunction HeuristicFunction = EGridHeuristicFunction::Octile);
+
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	bool AreLandmarksEnabled() const { return bLandmarksEnabled; }
+
+	/*
+	* Rebuilds the landmark tables from a tile snapshot on a worker thread, searches keep the current tables until the new ones arrive.
+	* Edits that make a tile cheaper or walkable drop the tables and start a refresh by themselves, other edits keep them.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void RefreshLandmarks();
+
+	/* True if searches can use the landmark tables right now */
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	bool AreLandmarksReady() const;
+
+	/* Memory used by the landmark tables in bytes */
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	int64 GetLandmarksAllocatedSize() const;
+
+	/*
+	* Flow field to GoalIndex: one reverse Dijkstra gives every tile its cost to the goal and its next step, see FGridFlowField.
+	* Fields are cached per goal, cost preferences (FAStarPreferences::HasSameCosts), bStopAtNeighborLocation and HeuristicFunction.
+	* A tile edit drops the cached fields that reached the tile, the least recently used field is dropped once the cache is full.
+	* With HasCustomNodeBehavior every call builds a new field that is not cached.
+	*/
+	TSharedPtr<const FGridFlowField> FindOrBuildFlowField(int32 GoalIndex, const FAStarPreferences& Preferences, bool bStopAtNeighborLocation = false, EGridHeuristicFunction HeuristicFunction = EGridHeuristicFunction::Octile);
+
+	/*
+	* AStarSearch result read from the cached flow field of GoalIndex, built on the first call.
+	* Many units walking to the same goal share one search, every further path costs O(path length).
+	* TotalNodeCostLimit and bRecordObstacleIndexes are not used.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	FSearchResult FlowFieldSearch(int32 StartIndex, int32 GoalIndex, FAStarPreferences Preferences, bool bStopAtNeighborLocation = false, EGridHeuristicFunction HeuristicFunction = EGridHeuristicFunction::Octile);
+
+	/* Number of flow fields kept, at least 1 */
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void SetFlowFieldCacheSize(int32 NumFields);
+
+	/* Drops every cached flow field, for costs that change without a tile edit */
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void InvalidateFlowFields();
+
+	/* Memory used by the cached flow fields in bytes */
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	int64 GetFlowFieldsAllocatedSize() const;
+
+	/*
+	* AStarSearch (and AStarSearch_Pure) results are kept in a least recently used cache keyed by the endpoints,
+	* bStopAtNeighborLocation, HeuristicFunction and the preferences. An entry is dropped when a tile changes in the
+	* 16x16 tile regions its search could have read, edits elsewhere keep it. Failed and cost limited searches
+	* depend on every tile. The least recently used entries are dropped to stay below MaxEntries and MaxBytes,
+	* 0 for either disables the cache. Used on the game thread without HasCustomNodeBehavior only.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void SetPathCacheLimits(int32 MaxEntries = 256, int64 MaxBytes = 4194304);
+
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void ClearPathCache();
+
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	FGridPathCacheStats GetPathCacheStats() const;
+
+	/*
+	* True if both tiles are walkable and joined by walkable tiles over the blocked border neighbors, in O(1).
+	* Tiles are labelled with their connected component when the grid is generated and the labels follow every tile edit.
+	* AStarSearch and the batch searches use them to fail walled off goals without expanding a tile.
+	*/
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	bool AreConnected(int32 FirstIndex, int32 SecondIndex) const;
+
+	/* Connected component id of a walkable tile, -1 for blocked tiles. Ids change with tile edits, compare them right away. */
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	int32 GetTileComponent(int32 Index) const;
+
+	/*
+	* Cheapest path from StartIndex to the closest of several goals in one search, instead of one AStarSearch per goal.
+	* EndPoint of the result is the goal that was reached. bStopAtNeighborLocation stops next to a goal.
+	* A partial path under TotalNodeCostLimit has its last tile as EndPoint.
+	* NodeBehavior gets a valid goal tile as EndIndex: the neighbor when it is a goal, otherwise the entry of GoalIndexes
+	* closest to the neighbor. Sets with tile predicates only pass the first goal tile of the grid, StartIndex if there is none.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	FSearchResult MultiGoalSearch(int32 StartIndex, const FGridGoalSet& Goals, FAStarPreferences Preferences, bool bStopAtNeighborLocation = false, EGridHeuristicFunction HeuristicFunction = EGridHeuristicFunction::Octile) const;
+
+	/*
+	* Windowed cooperative A* (WHCA*) for a group of agents in one pass, so units stop blocking each other in corridors.
+	* Agents are planned in query order. Each one searches (tile, time step) pairs for Window steps, a step moves to a
+	* neighbor or waits, skipping the pairs reserved by the agents before it and swaps with them, then reserves its own.
+	* The exact cost to the goal read from the flow field guides the search past the window, agents with the same goal
+	* and preferences share one field. PathTimes has the reservation time each tile is entered at, a gap between two
+	* entries is a wait on the earlier tile. Past the window the path continues along the flow field one step per time
+	* step without reservations, an agent that reaches its goal inside the window holds it.
+	* Earlier reservations of the queried agents are released. Plan again every Window / 2 steps to stay conflict free.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	TArray<FSearchResult> CooperativeSearchBatch(const TArray<FCooperativeSearchQuery>& Queries, int32 Window = 16);
+
+	/* Moves the reservations forward, call once per time step the agents move */
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void AdvanceReservationTime(int32 Steps = 1);
+
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	int32 GetReservationTime() const;
+
+	/* Holds the tile for an agent that is not planned by CooperativeSearchBatch, the cooperative searches route around it */
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void ReserveTile(int32 AgentId, int32 Index);
+
+	/* Agent that reserved the tile StepsAhead time steps from now, -1 if it is free */
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem|AStar")
+	int32 GetTileReservation(int32 Index, int32 StepsAhead = 0) const;
+
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void ReleaseReservations(int32 AgentId);
+
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	void ClearReservations();
+
+	/*
+	* Near optimal long range search on the cluster graph. Refines the first NumSegmentsToRefine segments, all if negative.
+	* Tiles in the same or touching clusters, tile filters, HasCustomNodeBehavior, bOverrideNodeCostToOne, wrapped borders,
+	* cost limits, obstacle recording, clusters waiting for their rebuild and calls off the game thread run a fully refined AStarSearch instead.
+	* The query never changes the hierarchy.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	FHierarchicalPath HierarchicalSearch(int32 StartIndex, int32 EndIndex, FAStarPreferences Preferences, int32 NumSegmentsToRefine = -1) const;
+
+	/*
+	* Refines the next NumSegments segments of Path, all if negative.
+	* Returns false if a segment is blocked by now or the hierarchy was rebuilt for a new layout, search again then.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	bool RefineHierarchicalPath(UPARAM(ref) FHierarchicalPath& Path, int32 NumSegments = 1) const;
+
+	/*
+	* Runs every query in parallel and returns the results in the same order.
+	* Blocks until all queries are done. Runs them one by one on the calling thread if NodeBehaviorRequiresGameThread(),
+	* which is the default for grids with a custom NodeBehavior.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|AStar")
+	TArray<FSearchResult> AStarSearchBatch(const TArray<FAStarSearchQuery>& Queries) const;
+
 	/*
 	* Finds all accessible nodes at range
 	*/
@@ -523,6 +1208,20 @@ public:
 		return PathSearchAtRange(StartIndex, AtRange, Preferences);
 	}
 
+	/*
+	* Compiles Preferences for this grid.
+	* The context can be reused for any number of searches while the grid size does not change.
+	*/
+	FGridQueryContext MakeQueryContext(const FAStarPreferences& Preferences) const;
+
+	/*
+	* AStarSearch and PathSearchAtRange with precompiled preferences
+	*/
+	FSearchResult AStarSearchWithContext(int32 StartIndex, int32 EndIndex, const FGridQueryContext& Context, bool bStopAtNeighborLocation = false, EGridHeuristicFunction HeuristicFunction = EGridHeuristicFunction::Octile) const;
+	FSearchResult JumpPointSearchWithContext(int32 StartIndex, int32 EndIndex, const FGridQueryContext& Context, bool bStopAtNeighborLocation = false, EGridHeuristicFunction HeuristicFunction = EGridHeuristicFunction::Octile) const;
+	FSearchResult PathSearchAtRangeWithContext(int32 StartIndex, int32 AtRange, const FGridQueryContext& Context) const;
+	FSearchResult MultiGoalSearchWithContext(int32 StartIndex, const FGridGoalSet& Goals, const FGridQueryContext& Context, bool bStopAtNeighborLocation = false, EGridHeuristicFunction HeuristicFunction = EGridHeuristicFunction::Octile) const;
+
 	/*
 	* For PathSearchAtRange function reconstructing paths
 	*/
@@ -561,9 +1260,19 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "DsPathfindingSystem|Grid")
 	FBox GetTileBox(int32 Index) const;
 
+	/*
+	* Returns the tile under the given world location, -1 if the point is off the grid.
+	* Constant time, works for square and hex grids in both tile orders.
+	*/
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "DsPathfindingSystem|Grid")
 	int32 GetTileIndex(FVector Point) const;
 
+	/*
+	* GetTileIndex for every point. Output has the same order and size as Points.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "DsPathfindingSystem|Grid")
+	TArray<int32> GetTileIndices(const TArray<FVector>& Points) const;
+
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "DsPathfindingSystem|Grid")
 	int32 GetGridSize() const;
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "DsPathfindingSystem|Grid")
@@ -581,6 +1290,11 @@ public:
 	int32 GetIndexRow(int32 Index) const;
 	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem")
 	int32 GetIndexColumn(int32 Index) const;
+	/*
+	* Inverse of GetIndexColumn/GetIndexRow. Returns -1 outside of the grid.
+	*/
+	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem")
+	int32 GetTileIndexAt(int32 Column, int32 Row) const;
 
 	UFUNCTION(BlueprintPure, Category = "DsPathfindingSystem")
 	EGridType GetGridType() const { return GridType; }
@@ -616,16 +1330,45 @@ public:
 	*	EAST and WEST SQUARE Grid Only
 	*/
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "DsPathfindingSystem|AStar")
-	FTileNeighborResult GetNeighborIndexes(int32 CurrentIndex, int32 EndIndex, FAStarPreferences Preferences) const;
+	FTileNeighborResult GetNeighborIndexes(int32 CurrentIndex, int32 EndIndex, const FAStarPreferences& Preferences) const;
+	FTileNeighborResult GetNeighborIndexesWithContext(int32 CurrentIndex, int32 EndIndex, const FGridQueryContext& Context) const;
 
 	/*
 	* Node cost and access logic.
 	* NeighborIndex is important. You need to return NeighborIndex(Node) values.
 	* The direction tells the neighbor Index to go according to the Current Index.
+	* Searches, flow fields, planners and path cost sums only call an override if UsesNodeBehavior,
+	* otherwise they read the tile attributes inline.
 	*/
 	UFUNCTION(BlueprintCallable, Category = "DsPathfindingSystem|Logic")
 	virtual FNodeAttribute NodeBehavior(int32 CurrentIndex, int32 NeighborIndex, int32 EndIndex, FAStarPreferences Preferences, ENeighborDirection Direction = ENeighborDirection::None) const;
 
+	/*
+	* True if NodeBehavior must run on the game thread, async queries and AStarSearchBatch then do not call it from worker threads.
+	* Defaults to HasCustomNodeBehavior, as overrides usually read units and actors. Return false if your override
+	* only reads the tile accessors, which see the snapshot of the query on worker threads.
+	*/
+	virtual bool NodeBehaviorRequiresGameThread() const { return HasCustomNodeBehavior(); }
+
+	/*
+	* True if NodeBehavior may change access or costs beyond the tile attributes.
+	* Searches that read the tile attributes directly (JumpPointSearch) then fall back to AStarSearch, and landmark bounds are not used.
+	* Native subclasses can override NodeBehavior and are assumed to, return false from your override if NodeBehavior is not overridden
+	* or only reads the tile attributes. Blueprint subclasses inherit the answer of their native parent.
+	*/
+	virtual bool HasCustomNodeBehavior() const;
+
+	/* True if the searches have to call NodeBehavior instead of reading the tile attributes */
+	FORCEINLINE bool UsesNodeBehavior() const
+	{
+		return HasCustomNodeBehavior() || NodeBehaviorRequiresGameThread();
+	}
+
+	/*
+	* Applies the compiled tile filters, then NodeBehavior.
+	*/
+	FNodeAttribute NodeBehaviorWithContext(int32 CurrentIndex, int32 NeighborIndex, int32 EndIndex, const FGridQueryContext& Context, ENeighborDirection Direction = ENeighborDirection::None) const;
+
 	/*
 	* returns neighbor node direction according to CurrentIndex
 	*/
@@ -664,11 +1407,14 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "DsPathfindingSystem|Grid")
 	FORCEINLINE FGridNode GetTile(int32 Index) const { return GetNode(Index); }
 
-	FORCEINLINE const FGridNode& GetNode(int32 Index) const
+	/*
+	* Builds the node from the dense tile storage. Out of range indexes are clamped like before.
+	*/
+	FORCEINLINE FGridNode GetNode(int32 Index) const
 	{
-		if (Instances.Num() == 0)
+		if (Tiles.Num() == 0)
 		{
-			static FGridNode InvalidNode(
+			FGridNode InvalidNode(
 				FVector::ZeroVector,
 				FNodeAttribute(false, 9999999.0f, ETileType::Undefined)
 			);
@@ -676,19 +1422,128 @@ public:
 			return InvalidNode;
 		}
 
-		if (Index >= Instances.Num())
-			return Instances[Instances.Num() - 1];
-		else if (Index < 0)
-			return Instances[0];
-		return Instances[Index];
+		Index = FMath::Clamp(Index, 0, Tiles.Num() - 1);
+		return FGridNode(GetTileLocation(Index), GetTileData().GetAttribute(Index));
+	}
+
+	/*
+	* Tile storage. Inside an async query this is the snapshot the query runs against.
+	*/
+	FORCEINLINE const FGridTileData& GetTileData() const
+	{
+		// Only threads inside a read scope have a snapshot to look up
+		return NumReadScopes.load(std::memory_order_relaxed) == 0 ? Tiles : GetScopedTileData();
 	}
 
+	/*
+	* Incremented on every tile or layout change.
+	*/
+	FORCEINLINE uint32 GetGridVersion() const { return GridVersion; }
+
+	/* Broadcast with the tile index after the attributes of a tile changed. Listeners may bind through a const grid. */
+	mutable FOnGridTileChanged OnTileChanged;
+
+	/* Broadcast before the layout or the tile storage is replaced (GenerateGridEx, Resize, ClearInstances) */
+	mutable FSimpleMulticastDelegate OnLayoutChanged;
+
+	/*
+	* Async AStarSearch/PathSearchAtRange, see FGridQueryService.
+	* Created by BeginPlay, or by the first call before that. Game thread only.
+	*/
+	FGridQueryService& GetQueryService() const;
+
+	/*
+	* Precomputed neighbor table, rebuilt by GenerateGridEx and Resize.
+	*/
+	FORCEINLINE const FGridAdjacency& GetAdjacency(bool bBlockBorder = true) const { return bBlockBorder ? BlockedAdjacency : WrappedAdjacency; }
+
+	/*
+	* Transpose of GetAdjacency: the row of a tile lists the tiles that have it as a neighbor.
+	* Wrapped borders and hex row parity make the neighbor relation asymmetric, so this is not the same table.
+	* Directions are those of the edge from the listed tile to the row tile.
+	*/
+	FORCEINLINE const FGridAdjacency& GetPredecessors(bool bBlockBorder = true) const { return bBlockBorder ? BlockedPredecessors : WrappedPredecessors; }
+
 private:
+	/* Shares the search helpers below */
+	friend class FGridTimeSlicedSearch;
+	/* Counts itself in NumReadScopes */
+	friend class FGridReadScope;
+
+	/* GetTileData while some thread is inside a read scope of this grid */
+	const FGridTileData& GetScopedTileData() const;
+
+	/* Builds the blocked border and wrap around neighbor tables and their transposes */
+	void BuildAdjacency();
+
+	/* Waits for async queries before the layout or tile storage is replaced */
+	void BeginLayoutChange();
+	/* Called after the attributes of a single tile changed */
+	void NotifyTileChanged(int32 Index);
+
+	/*
+	* A* expansions shared by AStarSearch, MultiGoalSearch and FGridTimeSlicedSearch, see FGridAStarRun in DsGridSearch.h.
+	* GoalType tells which popped tiles end the search, HeuristicType estimates the cost from a tile to the goals.
+	*/
+	template<typename KernelType, typename PolicyType, typename GoalType, typename HeuristicType>
+	void RunAStar(FGridSearchScratch& Scratch, FGridAStarRun& Run, const FGridQueryContext& Context, EGridHeuristicFunction HeuristicFunction, const PolicyType& Policy, const GoalType& Goal, const HeuristicType& Heuristic) const;
+	/* Path from StartIndex to LastIndex through the parents in Scratch, in the AStarSearch result layout */
+	FSearchResult RetraceSearch(const FGridSearchScratch& Scratch, int32 StartIndex, int32 LastIndex, int32 EndPoint, bool bStopAtNeighborLocation) const;
+
+	/* Search bodies, instantiated per neighbor kernel (see DsGridSearch.h) */
+	template<typename KernelType, typename PolicyType>
+	FSearchResult AStarSearchImpl(int32 StartIndex, int32 EndIndex, const FGridQueryContext& Context, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction, const PolicyType& Policy) const;
+	template<typename KernelType, typename PolicyType>
+	FSearchResult BidirectionalSearchImpl(int32 StartIndex, int32 EndIndex, const FGridQueryContext& Context, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction, const PolicyType& Policy) const;
+	template<typename KernelType, typename PolicyType>
+	FSearchResult PathSearchAtRangeImpl(int32 StartIndex, int32 AtRange, const FGridQueryContext& Context, const PolicyType& Policy) const;
+	template<typename KernelType, typename PolicyType>
+	FSearchResult MultiGoalSearchImpl(int32 StartIndex, const FGridGoalSet& Goals, const FGridQueryContext& Context, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction, const PolicyType& Policy) const;
+	template<typename JumperType>
+	FSearchResult JumpPointSearchImpl(int32 StartIndex, int32 EndIndex, const FGridQueryContext& Context, EGridHeuristicFunction HeuristicFunction, const JumperType& Grid) const;
+
+	/* Rebuilds or releases the JPS+ tables */
+	void BuildJumpPointTable();
+	/* Rebuilds or releases the HPA* clusters */
+	void BuildHierarchy();
+	/* Runs UpdateHierarchy on the game thread once for all tile edits of this frame */
+	void QueueHierarchyUpdate();
+	/* Rebuilds or releases the landmark tables on the calling thread */
+	void BuildLandmarks();
+	/* Landmark tables the query may use for its heuristic, nullptr if none */
+	const FGridLandmarks* FindLandmarks(const FGridQueryContext& Context, EGridHeuristicFunction HeuristicFunction) const;
+	/* Drops the cached flow fields whose costs depend on the tile */
+	void InvalidateFlowFieldsAt(int32 Index);
+	/* Drops the least recently used flow fields until at most MaxFields are left */
+	void TrimFlowFields(int32 MaxFields);
+	/* Rebuilds or releases the connected component labels */
+	void BuildComponents();
+	/* True if the connected components prove AStarSearch can not reach the goal, false if unsure */
+	bool IsGoalUnreachable(int32 StartIndex, int32 EndIndex, const FGridQueryContext& Context, bool bStopAtNeighborLocation) const;
+	/* Space-time search of one CooperativeSearchBatch agent guided by the flow field to its goal, reserves its path */
+	FSearchResult CooperativeSearch(const FCooperativeSearchQuery& Query, int32 Window, const TSharedPtr<const FGridFlowField>& Field);
+	/* AStarSearch through the path cache */
+	FSearchResult CachedAStarSearch(int32 StartIndex, int32 EndIndex, const FAStarPreferences& Preferences, bool bStopAtNeighborLocation, EGridHeuristicFunction HeuristicFunction) const;
+
 	TArray<int32> GetInstancesOverlappingBox(const FBox& Box) const;
 	TArray<int32> GetInstancesOverlappingSphere(const FVector& Center, const float Radius) const;
 
-	void AddInstance(FVector Instance, FNodeAttribute NewNode);
-	void CreateNewInstance(int32 Index, FNodeAttribute NewNode);
+	/* Distance between two neighbouring tile centers before TileScale is applied */
+	FVector2D GetTileStep() const;
+
+	/*
+	* Column/Row of the tile center closest to Point. The result is not clamped to the grid.
+	* Hex grids use cube rounding so the result is the hexagon that contains the point.
+	*/
+	bool GetNearestTileCoord(const FVector& Point, int32& OutColumn, int32& OutRow) const;
+	bool IsInsideTileXY(int32 Index, const FVector& Point) const;
+
+	/*
+	* Calls Function for every tile whose XY bounds may overlap [BoundsMin, BoundsMax].
+	* Only the covered rows/columns are visited, in row-major order.
+	*/
+	template<typename FunctionType>
+	void ForEachTileInBounds(const FVector& BoundsMin, const FVector& BoundsMax, FunctionType&& Function) const;
 
 private:
 	USceneComponent* Scene;
@@ -699,6 +1554,37 @@ private:
 	FVector2D TileOffset;
 	FBox TileBound;
 	FVector2D TileScale;
-	TMap<int32, FGridNode> Instances;
+	/* 1 / world distance between hex tile centers along X and between hex rows, see HexCubeDistance */
+	FVector2D HexStepInverse;
+	FVector GridOrigin;
+	FGridTileData Tiles;
+	/* Adjacency class of every tile, see FGridAdjacency */
+	TArray<uint8> TileClasses;
+	FGridAdjacency BlockedAdjacency;
+	FGridAdjacency WrappedAdjacency;
+	FGridAdjacency BlockedPredecessors;
+	FGridAdjacency WrappedPredecessors;
 	bool bSquareGridDiagonalAllowed;
+	uint32 GridVersion;
+	mutable TSharedPtr<FGridQueryService> QueryService;
+	/* Read scopes open on this grid over all threads */
+	mutable std::atomic<int32> NumReadScopes;
+	bool bJumpPointTablesEnabled;
+	TSharedPtr<FGridJumpPointTable> JumpPointTable;
+	bool bHierarchyEnabled;
+	int32 HierarchyClusterSize;
+	EGridHeuristicFunction HierarchyHeuristicFunction;
+	TSharedPtr<FGridHierarchy> Hierarchy;
+	bool bHierarchyUpdateQueued;
+	bool bLandmarksEnabled;
+	int32 LandmarkCount;
+	EGridHeuristicFunction LandmarkHeuristicFunction;
+	TSharedPtr<const FGridLandmarks> Landmarks;
+	TSharedPtr<FGridLandmarkRefresh> LandmarkRefresh;
+	int32 FlowFieldCacheSize;
+	uint64 FlowFieldUseCount;
+	TArray<TSharedPtr<FGridFlowField>> FlowFields;
+	TSharedPtr<FGridPathCache> PathCache;
+	TSharedPtr<FGridComponents> Components;
+	TSharedPtr<FGridReservationTable> Reservations;
 };
@@ -0,0 +1,92 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DsGrid.h"
+
+/*
+* Cost to one goal and the next step toward it for every tile, see ADsGrid::FindOrBuildFlowField.
+* Built by a Dijkstra from the goal over the predecessor table, step costs match AStarSearch.
+* With bStopAtNeighborLocation the neighbors of the goal are the targets, like AStarSearch stops next to it.
+* Costs only depend on the tiles the search reached, edits of other tiles leave the field valid (DependsOnTile).
+* Memory is 5 bytes per grid tile.
+*/
+class DSPATHFINDINGSYSTEM_API FGridFlowField
+{
+public:
+	FGridFlowField(const ADsGrid& Grid, int32 InGoalIndex, const FAStarPreferences& Preferences, bool bInStopAtNeighborLocation, EGridHeuristicFunction InHeuristicFunction);
+
+	FGridFlowField(const FGridFlowField&) = delete;
+	FGridFlowField& operator=(const FGridFlowField&) = delete;
+
+	FORCEINLINE int32 GetGoalIndex() const { return GoalIndex; }
+
+	/* True once the grid dropped the field for a tile edit or layout change, its paths may be out of date */
+	FORCEINLINE bool IsStale() const { return bStale; }
+
+	FORCEINLINE bool IsReachable(int32 Index) const
+	{
+		return CostToGoal.IsValidIndex(Index) && CostToGoal[Index] != MAX_flt;
+	}
+
+	/* Path cost from the tile to the goal, MAX_flt if the goal can not be reached */
+	FORCEINLINE float GetCostToGoal(int32 Index) const
+	{
+		return CostToGoal.IsValidIndex(Index) ? CostToGoal[Index] : MAX_flt;
+	}
+
+	/* Direction of the next step, None on the targets and on tiles that can not reach the goal */
+	FORCEINLINE ENeighborDirection GetDirection(int32 Index) const
+	{
+		return Directions.IsValidIndex(Index) ? Directions[Index] : ENeighborDirection::None;
+	}
+
+	/* Tile the next step enters, -1 if there is none */
+	int32 GetNextTile(const ADsGrid& Grid, int32 Index) const;
+
+	/* Follows the directions from StartIndex, same result layout as AStarSearch */
+	FSearchResult TracePath(const ADsGrid& Grid, int32 StartIndex) const;
+
+	/* True if editing the tile can change the field */
+	FORCEINLINE bool DependsOnTile(int32 Index) const
+	{
+		return Index == GoalIndex || IsReachable(Index);
+	}
+
+	bool Matches(int32 InGoalIndex, const FAStarPreferences& Preferences, bool bInStopAtNeighborLocation, EGridHeuristicFunction InHeuristicFunction) const
+	{
+		return GoalIndex == InGoalIndex
+			&& bStopAtNeighborLocation == bInStopAtNeighborLocation
+			&& HeuristicFunction == InHeuristicFunction
+			&& Context.Preferences.HasSameCosts(Preferences);
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return CostToGoal.GetAllocatedSize() + Directions.GetAllocatedSize();
+	}
+
+private:
+	friend class ADsGrid;
+
+	void Build(const ADsGrid& Grid);
+
+	const FGridQueryContext Context;
+	const int32 GoalIndex;
+	const bool bStopAtNeighborLocation;
+	const EGridHeuristicFunction HeuristicFunction;
+
+	TArray<float> CostToGoal;
+	TArray<ENeighborDirection> Directions;
+
+	/* Set by the grid when the field leaves the cache */
+	bool bStale = false;
+	/* Cache age for least recently used eviction */
+	uint64 LastUse = 0;
+};
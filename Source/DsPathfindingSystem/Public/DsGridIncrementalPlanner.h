@@ -0,0 +1,126 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DsGrid.h"
+
+/*
+* D* Lite planner for one agent and one goal, keeps its shortest path tree between Plan calls.
+* The tree is searched backwards from the goal, so the agent can move and tile edits only re-expand the tiles
+* whose cost to the goal changed. Edits through the ADsGrid setters are picked up from ADsGrid::OnTileChanged,
+* costs that change any other way (a custom NodeBehavior) are reported with NotifyTilesChanged.
+* Layout changes and a lower heuristic scale (see ADsGrid::GetHeuristicScale) start the tree over.
+* Step costs and results match AStarSearch. TotalNodeCostLimit and bRecordObstacleIndexes are not used.
+* Memory is about 20 bytes per grid tile. Game thread only, like tile edits.
+*/
+class DSPATHFINDINGSYSTEM_API FGridIncrementalPlanner
+{
+public:
+	FGridIncrementalPlanner(ADsGrid& InGrid, int32 InEndIndex, const FAStarPreferences& Preferences, bool bInStopAtNeighborLocation = false, EGridHeuristicFunction InHeuristicFunction = EGridHeuristicFunction::Octile);
+	~FGridIncrementalPlanner();
+
+	FGridIncrementalPlanner(const FGridIncrementalPlanner&) = delete;
+	FGridIncrementalPlanner& operator=(const FGridIncrementalPlanner&) = delete;
+
+	/*
+	* Repairs the tree for the tiles changed since the last call and returns the path from StartIndex.
+	* NumBackwardExpansions of the result counts the tiles expanded by this call.
+	*/
+	FSearchResult Plan(int32 StartIndex);
+
+	/* Marks tiles whose step costs changed without a tile edit */
+	void NotifyTilesChanged(const TArray<int32>& Indexes);
+	void NotifyTileChanged(int32 Index);
+
+	/* Drops the tree, the next Plan searches from scratch */
+	void Reset();
+
+	FORCEINLINE int32 GetEndIndex() const { return EndIndex; }
+
+	/* Expansions over every Plan call */
+	FORCEINLINE int32 GetNumExpansions() const { return NumExpansions; }
+
+	/* Times the tree was built from scratch */
+	FORCEINLINE int32 GetNumResets() const { return NumResets; }
+
+private:
+	/* D* Lite priority, compared lexicographically */
+	struct FKey
+	{
+		float Primary = 0.0f;
+		float Secondary = 0.0f;
+
+		FORCEINLINE bool operator<(const FKey& Other) const
+		{
+			return Primary < Other.Primary || (Primary == Other.Primary && Secondary < Other.Secondary);
+		}
+	};
+
+	void Initialize(int32 StartIndex);
+	void OnLayoutChanged();
+
+	FORCEINLINE bool IsGoal(int32 Index) const { return GoalIndexes.Contains(Index); }
+
+	/* Plan with the cost policy of the grid, see DispatchGridCostPolicy */
+	template<typename PolicyType>
+	FSearchResult PlanImpl(int32 InStartIndex, const PolicyType& Policy);
+
+	/* Cost of the step From -> To like AStarSearch charges it, MAX_flt if To can not be entered */
+	template<typename PolicyType>
+	float GetEdgeCost(const PolicyType& Policy, int32 From, int32 To, ENeighborDirection Direction, float* OutNodeCost = nullptr) const;
+	/* Cheapest step to a successor plus its cost to the goal */
+	template<typename PolicyType>
+	float ComputeRhs(const PolicyType& Policy, int32 Index) const;
+	FKey CalculateKey(int32 Index) const;
+	/* Recomputes rhs of the tile and calls UpdateQueue */
+	template<typename PolicyType>
+	void UpdateVertex(const PolicyType& Policy, int32 Index);
+	/* Queues the tile if its g and rhs differ, removes it otherwise */
+	void UpdateQueue(int32 Index);
+	template<typename PolicyType>
+	int32 ComputeShortestPath(const PolicyType& Policy);
+	template<typename PolicyType>
+	FSearchResult ExtractPath(const PolicyType& Policy) const;
+
+	void HeapPush(int32 Index, const FKey& Key);
+	void HeapRemove(int32 Index);
+	void HeapUpdate(int32 Index, const FKey& Key);
+	void HeapSiftUp(int32 Position);
+	void HeapSiftDown(int32 Position);
+	FORCEINLINE const FKey& TopKey() const { return Keys[Heap[0]]; }
+
+	TWeakObjectPtr<ADsGrid> Grid;
+	const FGridQueryContext Context;
+	const int32 EndIndex;
+	const bool bStopAtNeighborLocation;
+	const EGridHeuristicFunction HeuristicFunction;
+
+	FDelegateHandle TileChangedHandle;
+	FDelegateHandle LayoutChangedHandle;
+
+	/* Cost to the goal and its one step lookahead */
+	TArray<float> G;
+	TArray<float> Rhs;
+	TArray<FKey> Keys;
+	/* Position in Heap, INDEX_NONE if the tile is not queued */
+	TArray<int32> HeapIndex;
+	TArray<int32> Heap;
+
+	TArray<int32> GoalIndexes;
+	TSet<int32> ChangedTiles;
+
+	int32 StartIndex = INDEX_NONE;
+	/* Sum of the heuristic distances the start moved, keeps the queued keys valid without reordering them */
+	float KeyModifier = 0.0f;
+	float HeuristicScale = 1.0f;
+	bool bNeedsReset = true;
+
+	int32 NumExpansions = 0;
+	int32 NumResets = 0;
+};
@@ -0,0 +1,129 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+#include "DsGrid.h"
+
+DECLARE_DELEGATE_OneParam(FOnGridQueryComplete, const FSearchResult&);
+
+/*
+* Async query priority, mapped to UE task priorities.
+*/
+enum class EGridQueryPriority : uint8
+{
+	Low,
+	Normal,
+	High,
+};
+
+/*
+* Shared state of one async query.
+*/
+struct DSPATHFINDINGSYSTEM_API FGridQueryState
+{
+	FOnGridQueryComplete OnComplete;
+	FSearchResult Result;
+	std::atomic<bool> bCancelled{ false };
+	std::atomic<bool> bComplete{ false };
+
+	/* Game thread only. Stores the result and fires OnComplete unless the query was cancelled. */
+	void Complete(FSearchResult&& InResult);
+};
+
+/*
+* Handle returned for async queries.
+* Cancel() stops a query that did not start yet and always suppresses the completion delegate.
+*/
+struct DSPATHFINDINGSYSTEM_API FGridQueryHandle
+{
+	FGridQueryHandle() = default;
+	explicit FGridQueryHandle(TSharedPtr<FGridQueryState> InState)
+		: State(MoveTemp(InState))
+	{}
+
+	FORCEINLINE bool IsValid() const { return State.IsValid(); }
+	FORCEINLINE bool IsComplete() const { return State.IsValid() && State->bComplete; }
+	FORCEINLINE bool IsCancelled() const { return State.IsValid() && State->bCancelled; }
+
+	void Cancel() const
+	{
+		if (State.IsValid())
+			State->bCancelled = true;
+	}
+
+	/* Valid once IsComplete() returns true */
+	const FSearchResult& GetResult() const { return State->Result; }
+
+private:
+	TSharedPtr<FGridQueryState> State;
+};
+
+/*
+* Runs grid searches on the UE task system.
+* Each query reads an immutable snapshot of the tile data taken on the game thread when it was submitted,
+* so tiles can be edited while queries run. Queries submitted between two tile edits share one snapshot.
+* Snapshots no query reads anymore are brought up to date by copying the edited tiles only.
+* Grid layout changes (GenerateGridEx, Resize, ClearInstances) flush the service.
+* Grids whose NodeBehavior requires the game thread (ADsGrid::NodeBehaviorRequiresGameThread, true for any override by default)
+* run their queries as game thread tasks against the live tiles.
+*/
+class DSPATHFINDINGSYSTEM_API FGridQueryService
+{
+public:
+	explicit FGridQueryService(const ADsGrid& InGrid);
+	~FGridQueryService();
+
+	FGridQueryService(const FGridQueryService&) = delete;
+	FGridQueryService& operator=(const FGridQueryService&) = delete;
+
+	/* ADsGrid::AStarSearch on a worker thread */
+	FGridQueryHandle AStarSearch(int32 StartIndex, int32 EndIndex, const FAStarPreferences& Preferences, FOnGridQueryComplete OnComplete, EGridQueryPriority Priority = EGridQueryPriority::Normal, bool bStopAtNeighborLocation = false, EGridHeuristicFunction HeuristicFunction = EGridHeuristicFunction::Octile);
+
+	/* ADsGrid::PathSearchAtRange on a worker thread */
+	FGridQueryHandle PathSearchAtRange(int32 StartIndex, int32 AtRange, const FAStarPreferences& Preferences, FOnGridQueryComplete OnComplete, EGridQueryPriority Priority = EGridQueryPriority::Normal);
+
+	/* Game thread only. Query runs inside a read scope of the snapshot and must only read the grid. */
+	FGridQueryHandle Submit(TFunction<FSearchResult()> Query, FOnGridQueryComplete OnComplete, EGridQueryPriority Priority = EGridQueryPriority::Normal);
+
+	/* Cancels every query that did not complete yet */
+	void CancelAll();
+
+	/* Cancels every query and waits for the ones already running on worker threads */
+	void Flush();
+
+	/* Queries submitted and not completed or cancelled */
+	int32 GetNumPendingQueries() const;
+
+	/* Records a tile edit for the snapshots, called by the grid with its new version */
+	void MarkTileChanged(int32 Index, uint32 GridVersion);
+
+private:
+	TSharedPtr<const FGridTileData> GetSnapshot();
+	void PruneFinished();
+
+	const ADsGrid& Grid;
+
+	struct FSnapshot
+	{
+		TSharedPtr<FGridTileData> Tiles;
+		uint32 Version;
+	};
+	/* Most recent last. Older ones are kept to be patched once their queries are done. */
+	TArray<FSnapshot, TInlineAllocator<2>> Snapshots;
+	/* Version and index of every tile edit newer than the oldest snapshot */
+	TArray<TPair<uint32, int32>> ChangedTiles;
+
+	struct FPendingQuery
+	{
+		TSharedPtr<FGridQueryState> State;
+		UE::Tasks::FTask Task;
+	};
+	TArray<FPendingQuery> Pending;
+};
@@ -0,0 +1,94 @@
+/*
+* DsPathfindingSystem
+* Plugin code
+* Copyright (c) 2023 Davut Coşkun
+* All Rights Reserved.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DsGrid.h"
+
+class FGridSearchScratch;
+class FGridLandmarks;
+
+/*
+* AStarSearch that runs in slices, e.g. a few hundred expansions per frame, and returns the same result.
+* The open and closed sets stay in the search object between Step calls.
+* A tile edit between two steps makes the next Step start over from StartIndex only if the search already read the tile,
+* which is the start tile and the neighbors of closed tiles. Edits elsewhere are read when the search gets there.
+* A lower heuristic scale or new landmark tables start over as well. After MaxRestarts restarts the search finishes on
+* the tiles it read, like a path planned before the edits. Layout changes always start over, if the grid no longer
+* has the start or end tile the search fails. Game thread only, like tile edits.
+*/
+class DSPATHFINDINGSYSTEM_API FGridTimeSlicedSearch
+{
+public:
+	FGridTimeSlicedSearch(const ADsGrid& InGrid, int32 InStartIndex, int32 InEndIndex, const FAStarPreferences& Preferences, bool bInStopAtNeighborLocation = false, EGridHeuristicFunction InHeuristicFunction = EGridHeuristicFunction::Octile);
+	~FGridTimeSlicedSearch();
+
+	FGridTimeSlicedSearch(const FGridTimeSlicedSearch&) = delete;
+	FGridTimeSlicedSearch& operator=(const FGridTimeSlicedSearch&) = delete;
+
+	/*
+	* Expands up to MaxExpansions tiles. A positive MaxMicroseconds ends the slice earlier once that much time passed.
+	* Returns true once the search is complete.
+	*/
+	bool Step(int32 MaxExpansions, double MaxMicroseconds = 0.0);
+
+	/* Runs the rest of the search now and returns its result */
+	const FSearchResult& Finish();
+
+	/* Drops the search state and starts over with the current tiles */
+	void Restart();
+
+	/* Restarts for tile edits before the search stops restarting, negative for no limit */
+	FORCEINLINE void SetMaxRestarts(int32 InMaxRestarts) { MaxRestarts = InMaxRestarts; }
+
+	FORCEINLINE bool IsComplete() const { return bComplete; }
+
+	/* Valid once IsComplete() returns true, ready for ADsAIController::GridBasedMoveToSearchResult */
+	FORCEINLINE const FSearchResult& GetResult() const { return Result; }
+
+	/* Expansions over every slice, including the ones thrown away by restarts */
+	FORCEINLINE int32 GetNumExpansions() const { return NumExpansions; }
+
+	/* Times the search started over because the grid changed */
+	FORCEINLINE int32 GetNumRestarts() const { return NumRestarts; }
+
+private:
+	/* Validates the query and pushes the start tile, completes the search right away if there is nothing to search */
+	void Begin();
+	void Complete(FSearchResult&& InResult);
+
+	void OnTileChanged(int32 Index);
+	void OnLayoutChanged();
+
+	TWeakObjectPtr<const ADsGrid> Grid;
+	const FGridQueryContext Context;
+	const int32 StartIndex;
+	const int32 EndIndex;
+	const bool bStopAtNeighborLocation;
+	const EGridHeuristicFunction HeuristicFunction;
+
+	TUniquePtr<FGridSearchScratch> Scratch;
+	TArray<int32> StopAtNeighbor;
+	TArray<int32> ObstacleIndexes;
+	FSearchResult Result;
+
+	FDelegateHandle TileChangedHandle;
+	FDelegateHandle LayoutChangedHandle;
+	/* Heuristic inputs of the open nodes */
+	float HeuristicScale = 1.0f;
+	const FGridLandmarks* Landmarks = nullptr;
+
+	int32 NumRunExpansions = 0;
+	int32 NumExpansions = 0;
+	int32 NumRestarts = 0;
+	int32 MaxRestarts = 8;
+	bool bComplete = false;
+	/* An edit reached a tile the search read */
+	bool bTilesChanged = false;
+	bool bLayoutChanged = false;
+};